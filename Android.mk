@@ -10,11 +10,13 @@ LOCAL_C_INCLUDES := $(LOCAL_PATH)/$(SDL_PATH)/include
 LOCAL_SRC_FILES := ./main.c\
 ./Gx/App/GxApp.c\
 ./Gx/Array/GxArray.c\
+./Gx/Broadphase/GxBroadphase.c\
 ./Gx/Button/GxButton.c\
 ./Gx/Element/GxElement.c\
 ./Gx/Event/GxEvent.c\
 ./Gx/Folder/GxFolder.c\
 ./Gx/Graphics/GxGraphics.c\
+./Gx/Grid/GxGrid.c\
 ./Gx/List/GxList.c\
 ./Gx/Map/GxMap.c\
 ./Gx/Namespace/GxNamespace.c\
@@ -23,6 +25,7 @@ LOCAL_SRC_FILES := ./main.c\
 ./Gx/Renderable/GxRenderable.c\
 ./Gx/RigidBody/GxRigidBody.c\
 ./Gx/Scene/GxScene.c\
+./Gx/Snapshot/GxSnapshot.c\
 ./Gx/Tilemap/GxTilemap.c\
 ./Gx/Utilities/GxUtil.c\
 
@@ -0,0 +1,265 @@
+#include "../Gx/Utilities/GxUtil.h"
+#include "../Gx/Ini/GxIni.h"
+#include "../Gx/App/GxApp.h"
+#include "../Gx/Scene/GxScene.h"
+#include "../Gx/Element/GxElement.h"
+#include "../Gx/RigidBody/GxRigidBody.h"
+#include "../Gx/Physics/GxPhysics.h"
+#include "../Gx/Snapshot/GxSnapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Headless physics benchmark. Every workload builds its scene through the public API, runs
+//it with the dummy SDL drivers and prints one JSON object per step, then a summary line.
+//usage: GxBench [workload|all] [count] [steps] [tight|loose|grid] [cellSize]
+//allocations counts every heap growth of the physics module, rendering is not included
+
+//... TYPES
+typedef struct Workload {
+	const char* name;
+	int count; //default number of bodies or tiles
+	int gravity;
+	GxSize size;
+	void (*build)(int count);
+	bool replay; //restores a snapshot of the first step and checks the rerun repeats the run
+} Workload;
+
+//... STATIC
+static Uint32 sSeed = 1;
+static int sCount = 0;
+static const Workload* sWorkload = NULL;
+static bool sLoose = false;
+static int sBroadphase = GxBroadphaseQuadtree;
+static int sCellSize = 0;
+static GxElement** sReplayed = NULL; //dynamic bodies compared by replay workloads
+static int sReplayedCount = 0;
+
+static const int kDefaultSteps = 300;
+
+static inline int benchRandom(int min, int max) {
+	//deterministic, so every run measures the same scene
+	sSeed = sSeed * 1103515245u + 12345u;
+	return min + (int) ((sSeed >> 16) % (Uint32) (max - min + 1));
+}
+
+static inline GxElement* benchCreate(int body, SDL_Rect pos, GxVector velocity) {
+	return GxCreateElement(&(GxIni) {
+		.display = GxElemNone,
+		.body = body,
+		.position = &pos,
+		.velocity = velocity,
+	});
+}
+
+//... WORKLOADS
+static void buildBoxes(int count) {
+	//boxes falling on a floor, spread over the whole scene
+	GxSize size = sWorkload->size;
+	benchCreate(GxElemFixed, (SDL_Rect) { 0, 0, size.w, 16 }, (GxVector) { 0, 0 });
+	for (int i = 0; i < count; i++) {
+		SDL_Rect pos = { benchRandom(0, size.w - 16), benchRandom(32, size.h - 16), 12, 12 };
+		benchCreate(GxElemDynamic, pos, (GxVector) { 0, 0 });
+	}
+}
+
+static void buildPile(int count) {
+	//boxes stacked in a few narrow columns, every one resting on another
+	int columns = count / 50 + 1;
+	benchCreate(GxElemFixed, (SDL_Rect) { 0, 0, sWorkload->size.w, 16 }, (GxVector) { 0, 0 });
+	for (int i = 0; i < count; i++) {
+		int column = i % columns, row = i / columns;
+		SDL_Rect pos = { 32 + column * 24, 16 + row * 12, 10, 10 };
+		benchCreate(GxElemDynamic, pos, (GxVector) { 0, 0 });
+	}
+}
+
+static void buildBullets(int count) {
+	//small fast bodies crossing each other without gravity
+	GxSize size = sWorkload->size;
+	for (int i = 0; i < count; i++) {
+		SDL_Rect pos = { benchRandom(8, size.w - 16), benchRandom(8, size.h - 16), 4, 4 };
+		GxVector velocity = { benchRandom(-20, 20), benchRandom(-20, 20) };
+		GxElement* bullet = benchCreate(GxElemDynamic, pos, velocity);
+		GxElemSetElasticity(bullet, 1.0);
+	}
+}
+
+static void buildTilemap(int count) {
+	//a large grid of fixed tiles with a few boxes bouncing on it
+	GxSize size = sWorkload->size;
+	int columns = size.w / 32;
+	for (int i = 0; i < count; i++) {
+		int column = i % columns, row = i / columns;
+		if (benchRandom(0, 3) == 0) continue;
+		benchCreate(GxElemFixed, (SDL_Rect) { column * 32, row * 32, 32, 32 }, (GxVector) { 0, 0 });
+	}
+	int top = (count / columns + 2) * 32;
+	for (int i = 0; i < count / 20; i++) {
+		SDL_Rect pos = { benchRandom(0, size.w - 16), benchRandom(top, size.h - 16), 12, 12 };
+		benchCreate(GxElemDynamic, pos, (GxVector) { benchRandom(-6, 6), 0 });
+	}
+}
+
+static void buildReplay(int count) {
+	//boxes falling through sensors onto a floor, next to an element with neither
+	//renderable nor body, which a snapshot must skip
+	GxSize size = sWorkload->size;
+	GxCreateElement(&(GxIni) { .display = GxElemNone, .body = GxElemNone });
+	benchCreate(GxElemFixed, (SDL_Rect) { 0, 0, size.w, 16 }, (GxVector) { 0, 0 });
+	for (int i = 0; i < 8; i++) {
+		benchCreate(GxElemSensor, (SDL_Rect) { i * size.w / 8, 16, size.w / 16, 64 }, (GxVector) { 0, 0 });
+	}
+
+	sReplayed = realloc(sReplayed, (count ? count : 1) * sizeof(GxElement*));
+	GxAssertAllocationFailure(sReplayed);
+	sReplayedCount = count;
+	for (int i = 0; i < count; i++) {
+		SDL_Rect pos = { benchRandom(0, size.w - 16), benchRandom(32, size.h - 16), 12, 12 };
+		sReplayed[i] = benchCreate(GxElemDynamic, pos, (GxVector) { benchRandom(-4, 4), 0 });
+		GxElemSetElasticity(sReplayed[i], 0.3);
+	}
+}
+
+static const Workload kWorkloads[] = {
+	{ "boxes", 1000, 60, { 4096, 2048 }, buildBoxes },
+	{ "pile", 1000, 60, { 2048, 2048 }, buildPile },
+	{ "bullets", 2000, 0, { 4096, 4096 }, buildBullets },
+	{ "tilemap", 8192, 60, { 4096, 4096 }, buildTilemap },
+	{ "replay", 1000, 60, { 4096, 2048 }, buildReplay, true },
+};
+
+static const int kTotalWorkloads = sizeof(kWorkloads) / sizeof(Workload);
+
+//... RUN
+static void benchOnLoad(GxEvent* e) {
+	(void) e;
+	sWorkload->build(sCount);
+}
+
+static Uint64 benchChecksum(void) {
+	//FNV-1a over the state of the replayed bodies
+	Uint64 hash = 14695981039346656037ull;
+	for (int i = 0; i < sReplayedCount; i++) {
+		const SDL_Rect* pos = GxElemGetPosition(sReplayed[i]);
+		GxVector velocity = GxElemGetVelocity(sReplayed[i]);
+		int values[] = { pos->x, pos->y, velocity.x, velocity.y, GxElemIsOnGround(sReplayed[i]) };
+		for (int k = 0; k < 5; k++) {
+			hash ^= (Uint32) values[k];
+			hash *= 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+static bool benchRun(const Workload* workload, int count, int steps) {
+
+	sWorkload = workload;
+	sCount = count;
+	sSeed = 1;
+
+	SDL_Rect area = { 0, 0, workload->size.w, workload->size.h };
+	GxScene* scene = GxCreateScene(&(GxIni) {
+		.name = workload->name,
+		.size = workload->size,
+		.gravity = workload->gravity,
+		.simArea = &area,
+		.looseTrees = sLoose,
+		.broadphase = sBroadphase,
+		.cellSize = sCellSize,
+		.onLoad = benchOnLoad,
+	});
+
+	//the first update loads the scene
+	GxLoadScene(scene);
+	GxSceneOnUpdate_(scene);
+	GxSnapshot snapshot = { 0 };
+	if (workload->replay) GxSceneSaveSnapshot(scene, &snapshot);
+
+	double frequency = (double) SDL_GetPerformanceFrequency();
+	GxPhysicsStats first = GxPhysicsGetStats_(GxSceneGetPhysics(scene));
+	GxPhysicsStats last = first;
+	double total = 0.0, worst = 0.0;
+
+	for (int i = 0; i < steps; i++) {
+		Uint64 counter = SDL_GetPerformanceCounter();
+		GxSceneOnUpdate_(scene);
+		double us = (SDL_GetPerformanceCounter() - counter) * 1e6 / frequency;
+		GxPhysicsStats stats = GxPhysicsGetStats_(GxSceneGetPhysics(scene));
+		printf("{\"workload\":\"%s\",\"count\":%d,\"step\":%d,\"us\":%.1f,\"physics_us\":%.1f,"
+			"\"bodies\":%llu,\"contacts\":%llu,\"queries\":%llu,\"allocations\":%llu,\"nodes\":%u,\"depth\":%d}\n",
+			workload->name, count, i, us, (stats.counter - last.counter) * 1e6 / frequency,
+			(unsigned long long) (stats.bodies - last.bodies),
+			(unsigned long long) (stats.contacts - last.contacts),
+			(unsigned long long) (stats.queries - last.queries),
+			(unsigned long long) (stats.allocations - last.allocations),
+			stats.nodes, stats.depth
+		);
+		total += us;
+		if (us > worst) worst = us;
+		last = stats;
+	}
+
+	//reruns the steps from the snapshot, after changing a filter the restore must undo
+	bool identical = true;
+	if (workload->replay) {
+		Uint64 checksum = benchChecksum();
+		if (sReplayedCount) GxElemSetCmask(sReplayed[0], GxCmaskNone);
+		if (GxSceneRestoreSnapshot(scene, &snapshot)) {
+			for (int i = 0; i < steps; i++) GxSceneOnUpdate_(scene);
+			identical = benchChecksum() == checksum;
+		}
+		else {
+			identical = false;
+		}
+		GxFreeSnapshot(&snapshot);
+	}
+
+	printf("{\"workload\":\"%s\",\"count\":%d,\"steps\":%d,\"mean_us\":%.1f,\"max_us\":%.1f,"
+		"\"physics_us\":%.1f,\"contacts\":%llu,\"queries\":%llu,\"allocations\":%llu,\"nodes\":%u,\"depth\":%d%s}\n",
+		workload->name, count, steps, steps ? total / steps : 0.0, worst,
+		steps ? (last.counter - first.counter) * 1e6 / frequency / steps : 0.0,
+		(unsigned long long) (last.contacts - first.contacts),
+		(unsigned long long) (last.queries - first.queries),
+		(unsigned long long) (last.allocations - first.allocations),
+		last.nodes, last.depth,
+		workload->replay ? (identical ? ",\"identical\":true" : ",\"identical\":false") : ""
+	);
+	fflush(stdout);
+	return identical;
+}
+
+int main(int argc, char** argv) {
+
+	//no window or audio device is needed
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+
+	const char* name = argc > 1 ? argv[1] : "all";
+	int count = argc > 2 ? atoi(argv[2]) : 0;
+	int steps = argc > 3 ? atoi(argv[3]) : kDefaultSteps;
+	sLoose = argc > 4 && strcmp(argv[4], "loose") == 0;
+	sBroadphase = argc > 4 && strcmp(argv[4], "grid") == 0 ? GxBroadphaseGrid : GxBroadphaseQuadtree;
+	sCellSize = argc > 5 ? atoi(argv[5]) : 0;
+
+	GxCreateApp(&(GxIni) {
+		.window = "Landscape|360",
+		.title = "GxBench",
+	});
+
+	bool found = false, identical = true;
+	for (int i = 0; i < kTotalWorkloads; i++) {
+		const Workload* workload = &kWorkloads[i];
+		if (strcmp(name, "all") && strcmp(name, workload->name)) continue;
+		identical = benchRun(workload, count > 0 ? count : workload->count, steps) && identical;
+		found = true;
+	}
+
+	if (!found) {
+		fprintf(stderr, "unknown workload '%s', expected all", name);
+		for (int i = 0; i < kTotalWorkloads; i++) fprintf(stderr, ", %s", kWorkloads[i].name);
+		fprintf(stderr, "\n");
+		return 1;
+	}
+	return identical ? 0 : 1;
+}
@@ -152,7 +152,11 @@ GxScene* GxCreateApp(const GxIni* ini) {
 
     if (!(self->renderer = SDL_CreateRenderer(self->window, -1, 
         SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_ACCELERATED))) {
-         GxRuntimeError(SDL_GetError());
+        //headless video drivers (SDL_VIDEODRIVER=dummy) only have the software renderer,
+        //a machine with a GPU still gets the accelerated one
+        if (!(self->renderer = SDL_CreateRenderer(self->window, -1, SDL_RENDERER_SOFTWARE))) {
+            GxRuntimeError(SDL_GetError());
+        }
     }
 
     //present window
@@ -450,8 +454,11 @@ void GxLoadScene(GxScene* scene) {
 
     if (scene != self->snMain){
         if(self->snActive){
+            //the unloaded scene runs its own teardown, then the loaded one takes over, so
+            //elements created right after this call belong to it
             self->snRunning = self->snActive;
             GxSceneUnload_(self->snActive);
+            self->snRunning = scene;
         }
         self->snActive = scene;
     }
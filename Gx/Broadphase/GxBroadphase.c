@@ -0,0 +1,130 @@
+#include "../Utilities/GxUtil.h"
+#include "../Broadphase/GxBroadphase.h"
+#include "../Quadtree/GxQuadtree.h"
+#include "../Grid/GxGrid.h"
+#include "../Scene/GxScene.h"
+#include "../Element/GxElement.h"
+#include <stdlib.h>
+
+//... type
+//dispatches every call to the index the scene chose, exactly one of them is set
+typedef struct GxBroadphase {
+	GxQtree* qtree;
+	GxGrid* grid;
+} GxBroadphase;
+
+GxBroadphase* GxCreateBroadphase_(GxScene* scene, SDL_Rect pos) {
+	GxBroadphase* self = calloc(1, sizeof(GxBroadphase));
+	GxAssertAllocationFailure(self);
+	if (GxSceneGetBroadphase(scene) == GxBroadphaseGrid) {
+		self->grid = GxCreateGrid_(pos, GxSceneGetCellSize(scene));
+	}
+	else {
+		self->qtree = GxCreateQtree_(pos, GxSceneHasLooseTrees(scene));
+	}
+	return self;
+}
+
+void GxDestroyBroadphase_(GxBroadphase* self) {
+	if (self) {
+		GxDestroyQtree_(self->qtree);
+		GxDestroyGrid_(self->grid);
+		free(self);
+	}
+}
+
+//acessors
+SDL_Rect GxBroadphaseGetPosition_(GxBroadphase* self) {
+	return self->grid ? GxGridGetPosition_(self->grid) : GxQtreeGetPosition_(self->qtree);
+}
+
+GxBroadphaseStats GxBroadphaseGetStats_(GxBroadphase* self) {
+	return self->grid ? GxGridGetStats_(self->grid) : GxQtreeGetStats_(self->qtree);
+}
+
+//methods
+void GxBroadphaseInsert_(GxBroadphase* self, GxElement* element) {
+	if (self->grid) GxGridInsert_(self->grid, element);
+	else GxQtreeInsert_(self->qtree, element);
+}
+
+void GxBroadphaseRemove_(GxBroadphase* self, GxElement* element) {
+	if (self->grid) GxGridRemove_(self->grid, element);
+	else GxQtreeRemove_(self->qtree, element);
+}
+
+void GxBroadphaseUpdate_(GxBroadphase* self, GxElement* element, SDL_Rect previous) {
+	if (self->grid) GxGridUpdate_(self->grid, element, previous);
+	else GxQtreeUpdate_(self->qtree, element, previous);
+}
+
+void GxBroadphaseRefresh_(GxBroadphase* self, GxElement* element) {
+	if (self->grid) GxGridRefresh_(self->grid, element);
+	else GxQtreeRefresh_(self->qtree, element);
+}
+
+void GxBroadphaseRebalance_(GxBroadphase* self) {
+	if (self->grid) GxGridRebalance_(self->grid);
+	else GxQtreeRebalance_(self->qtree);
+}
+
+void GxBroadphaseCollect_(GxBroadphase* self, SDL_Rect area, GxElemBuffer* out) {
+	if (self->grid) GxGridCollect_(self->grid, area, out);
+	else GxQtreeCollect_(self->qtree, area, out);
+}
+
+void GxBroadphaseCollectFiltered_(GxBroadphase* self, SDL_Rect area, GxBroadphaseFilter filter, GxElemBuffer* out) {
+	if (self->grid) GxGridCollectFiltered_(self->grid, area, filter, out);
+	else GxQtreeCollectFiltered_(self->qtree, area, filter, out);
+}
+
+void GxBroadphaseCollectSegment_(GxBroadphase* self, SDL_Point from, SDL_Point to,
+	GxBroadphaseFilter filter, GxElemBuffer* out)
+{
+	if (self->grid) GxGridCollectSegment_(self->grid, from, to, filter, out);
+	else GxQtreeCollectSegment_(self->qtree, from, to, filter, out);
+}
+
+void GxBroadphaseQuery_(GxBroadphase* self, SDL_Rect area, GxElemBuffer* found,
+	GxBroadphaseCallback callback, void* context)
+{
+	//the elements are gathered and deduplicated in the caller's buffer before the first
+	//callback, so the callback may move elements or run queries of its own
+	found->size = 0;
+	GxBroadphaseCollect_(self, area, found);
+	GxElemBufferSortUnique_(found);
+	for (Uint32 i = 0; i < found->size; i++) callback(found->elems[i], context);
+}
+
+//... ELEMENT BUFFER
+void GxElemBufferPush_(GxElemBuffer* self, GxElement* elem) {
+	if (self->size == self->capacity) {
+		self->capacity = self->capacity ? self->capacity * 2 : 16;
+		self->elems = realloc(self->elems, self->capacity * sizeof(GxElement*));
+		GxAssertAllocationFailure(self->elems);
+		self->allocations++;
+	}
+	self->elems[self->size++] = elem;
+}
+
+static int elemBufferCompare(const void* lhs, const void* rhs) {
+	Uint32 l = GxElemGetId(*(GxElement**) lhs);
+	Uint32 r = GxElemGetId(*(GxElement**) rhs);
+	return (l > r) - (l < r);
+}
+
+void GxElemBufferSortUnique_(GxElemBuffer* self) {
+	if (self->size < 2) return;
+	qsort(self->elems, self->size, sizeof(GxElement*), elemBufferCompare);
+	Uint32 size = 1;
+	for (Uint32 i = 1; i < self->size; i++) {
+		if (self->elems[i] != self->elems[size - 1]) self->elems[size++] = self->elems[i];
+	}
+	self->size = size;
+}
+
+void GxElemBufferFree_(GxElemBuffer* self) {
+	free(self->elems);
+	self->elems = NULL;
+	self->size = self->capacity = 0;
+}
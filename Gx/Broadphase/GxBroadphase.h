@@ -0,0 +1,57 @@
+#ifndef GX_BROADPHASE_H
+#define GX_BROADPHASE_H
+#include "../Utilities/GxUtil.h"
+
+//spatial index behind the physics and graphics modules, a quadtree or a hashed grid
+//as chosen by the scene
+typedef struct GxBroadphase GxBroadphase;
+
+//growable element buffer owned by the caller, so queries can run concurrently
+typedef struct GxElemBuffer {
+	GxElement** elems;
+	Uint32 size;
+	Uint32 capacity;
+	Uint32 allocations; //times the array grew
+} GxElemBuffer;
+
+//collision filter of a query, tested against the cmask and layer cached in the index entries
+typedef struct GxBroadphaseFilter {
+	Uint32 cmask;
+	Uint32 layers; //bit set of the layers that pass
+} GxBroadphaseFilter;
+
+//shape of an index, for verification and benchmarks
+typedef struct GxBroadphaseStats {
+	Uint32 nodes; //tree nodes, or grid cells in the table
+	Uint32 leaves; //tree leaves, or grid cells holding entries
+	Uint32 entries; //an element crossing several leaves or cells counts once per each
+	int depth; //0 while the root is a leaf, always 0 for grids
+	Uint64 allocations; //times the node pool, cell table, home map or entry arrays grew
+} GxBroadphaseStats;
+
+//called by a query for every element found, with the context the query was given
+typedef void (*GxBroadphaseCallback)(GxElement* elem, void* context);
+
+GxBroadphase* GxCreateBroadphase_(GxScene* scene, SDL_Rect pos);
+void GxDestroyBroadphase_(GxBroadphase* self);
+SDL_Rect GxBroadphaseGetPosition_(GxBroadphase* self);
+GxBroadphaseStats GxBroadphaseGetStats_(GxBroadphase* self);
+void GxBroadphaseInsert_(GxBroadphase* self, GxElement* element);
+void GxBroadphaseRemove_(GxBroadphase* self, GxElement* element);
+void GxBroadphaseUpdate_(GxBroadphase* self, GxElement* element, SDL_Rect previous);
+void GxBroadphaseRefresh_(GxBroadphase* self, GxElement* element);
+void GxBroadphaseRebalance_(GxBroadphase* self);
+void GxBroadphaseCollect_(GxBroadphase* self, SDL_Rect area, GxElemBuffer* out);
+void GxBroadphaseCollectFiltered_(GxBroadphase* self, SDL_Rect area, GxBroadphaseFilter filter, GxElemBuffer* out);
+void GxBroadphaseCollectSegment_(GxBroadphase* self, SDL_Point from, SDL_Point to,
+	GxBroadphaseFilter filter, GxElemBuffer* out
+);
+void GxBroadphaseQuery_(GxBroadphase* self, SDL_Rect area, GxElemBuffer* found,
+	GxBroadphaseCallback callback, void* context
+);
+
+void GxElemBufferPush_(GxElemBuffer* self, GxElement* elem);
+void GxElemBufferSortUnique_(GxElemBuffer* self);
+void GxElemBufferFree_(GxElemBuffer* self);
+
+#endif // !GX_BROADPHASE_H
@@ -6,13 +6,23 @@
 #include "../Folder/GxFolder.h"
 #include "../Graphics/GxGraphics.h"
 #include "../Physics/GxPhysics.h"
+#include "../RigidBody/GxRigidBody.h"
 #include "../Scene/GxScene.h"
 #include <string.h>
 #include "../Renderable/GxRenderable.h"
 #include "../Map/GxMap.h"
+#include "../Snapshot/GxSnapshot.h"
 
 
 
+//state of an element in snapshots, followed by its body and contacts when it has one
+typedef struct ElemState {
+	Uint32 id;
+	SDL_Rect pos;
+	SDL_Point lastPos;
+	Uint32 lastTick;
+} ElemState;
+
 GxElement* GxCreateElement(const GxIni* ini){
 
 	GxElement* self = malloc(sizeof(GxElement));
@@ -45,16 +55,19 @@ GxElement* GxCreateElement(const GxIni* ini){
 		self->pos = malloc(sizeof(SDL_Rect));
 		GxAssertAllocationFailure(self->pos);
 		*self->pos = *ini->position; 
+		self->lastPos = (SDL_Point) { self->pos->x, self->pos->y };
 	}
 	else {
 		self->pos = NULL;
+		self->lastPos = (SDL_Point) { 0, 0 };
 	}
+	self->lastTick = 0;
 
 	//getHandler and putHandler		
 	self->rHandlers = NULL;
 
 	//add element to scene then return
-	self->id = GxSceneAddElement_(self->scene, self);
+	GxSceneAddElement_(self->scene, self, &self->id);
 	return self;
 }
 
@@ -143,6 +156,17 @@ void GxElemExecuteContactHandler_(GxElement* self, int type, GxContact* contact)
 	}
 }
 
+void GxElemExecuteSensorHandler_(GxElement* self, int type, GxElement* other){
+	validateElem(self, false, false);
+	if(self->handlers && self->handlers[type]){
+		self->handlers[type](&(GxEvent){
+			.type = type, 
+			.target = self->target,
+			.other = other,			
+		});
+	}
+}
+
 bool GxElemHasClass(GxElement* self, const char* type) {
 	validateElem(self, false, false);	
 	if (!self->classList) {
@@ -179,7 +203,10 @@ void GxElemSetPosition(GxElement* self, SDL_Rect pos) {
 	GxPhysics* physics = GxSceneGetPhysics(self->scene);
 	if (self->renderable) GxGraphicsRemoveElement_(graphics, self);
 	if (self->body) GxPhysicsRemoveElement_(physics, self);
+	if (self->body) GxElemWake(self);
 	*self->pos = pos;
+	self->lastPos = (SDL_Point) { pos.x, pos.y };
+	self->lastTick = GxSceneGetTick_(self->scene);
 	if (self->renderable)GxGraphicsInsertElement_(graphics, self);
 	if (self->body) GxPhysicsInsertElement_(physics, self);	
 }
@@ -209,3 +236,38 @@ void* GxElemGetChild(GxElement* self) {
 	validateElem(self, false, false);
 	return self->child;
 }
+
+void GxElemSaveState_(GxElement* self, GxSnapshot* snapshot) {
+	validateElem(self, false, false);
+	//an element without renderable or body has no position
+	ElemState state = { self->id, self->pos ? *self->pos : (SDL_Rect) { 0 }, self->lastPos, self->lastTick };
+	GxSnapshotWrite_(snapshot, &state, sizeof(ElemState));
+	if (self->body) {
+		GxElemSaveBody_(self, snapshot);
+		GxPhysicsSaveContacts_(GxSceneGetPhysics(self->scene), self, snapshot);
+	}
+}
+
+void GxElemRestoreState_(GxElement* self, const GxSnapshot* snapshot, size_t* offset) {
+	validateElem(self, false, false);
+	ElemState state;
+	GxSnapshotRead_(snapshot, offset, &state, sizeof(ElemState));
+	GxAssertInvalidArgument(state.id == self->id);
+
+	//the trees are updated in place, unlike GxElemSetPosition this keeps the contacts
+	SDL_Rect previousPos = state.pos;
+	bool moved = self->pos && !SDL_RectEquals(self->pos, &state.pos);
+	if (moved) {
+		previousPos = *self->pos;
+		*self->pos = state.pos;
+		GxGraphicsUpdatePosition_(GxSceneGetGraphics(self->scene), self, previousPos);
+	}
+	self->lastPos = state.lastPos;
+	self->lastTick = state.lastTick;
+	if (self->body) {
+		GxPhysics* physics = GxSceneGetPhysics(self->scene);
+		bool filtered = GxElemRestoreBody_(self, snapshot, offset);
+		if (moved || filtered) GxPhysicsRestoreElement_(physics, self, previousPos, moved, filtered);
+		GxPhysicsRestoreContacts_(physics, self, snapshot, offset);
+	}
+}
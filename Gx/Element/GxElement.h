@@ -25,10 +25,12 @@ const char* GxElemGetClassName(GxElement* self);
 bool GxElemHasHandler(GxElement* self, int type);
 GxHandler GxElemGetHandler(GxElement* self, int type);
 void GxElemExecuteContactHandler_(GxElement* self, int type, GxContact* contact);
+void GxElemExecuteSensorHandler_(GxElement* self, int type, GxElement* other);
 
 bool GxElemHasClass(GxElement* self, const char* type);
 bool GxElemHasDynamicBody(GxElement* self);
 bool GxElemHasFixedBody(GxElement* self);
+bool GxElemIsSensor(GxElement* self);
 bool GxElemHasRelativePosition(GxElement* self);
 bool GxElemHasAbsolutePosition(GxElement* self);
 
@@ -43,5 +45,8 @@ bool GxElemIsRenderable(GxElement* self);
 void GxElemSetChild(GxElement* self, void* child);
 void* GxElemGetChild(GxElement* self);
 
+void GxElemSaveState_(GxElement* self, GxSnapshot* snapshot);
+void GxElemRestoreState_(GxElement* self, const GxSnapshot* snapshot, size_t* offset);
+
 #endif // !GX_ELEM_H
 
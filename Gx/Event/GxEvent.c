@@ -22,6 +22,8 @@ void GxEventSetHandlers_(GxHandler* handlers, const GxIni* ini) {
     handlers[GxEventPreContact] = ini->onPreContact;
     handlers[GxEventContactBegin] = ini->onContactBegin;
     handlers[GxEventContactEnd] = ini->onContactEnd;
+    handlers[GxEventSensorEnter] = ini->onSensorEnter;
+    handlers[GxEventSensorExit] = ini->onSensorExit;
     handlers[GxEventOnDestroy] = ini->onDestroy;    
 }
 
@@ -30,7 +32,8 @@ bool GxEventIniHasHandler_(const GxIni* ini) {
         ini->onPreGraphical || ini->onPreRender || ini->onLoopEnd ||
         ini->onUnload || ini->onKeyboard || ini->onMouse ||
         ini->onFinger || ini->onSDLDefault || ini->onPreContact ||
-        ini->onContactBegin || ini->onContactEnd || ini->onDestroy);
+        ini->onContactBegin || ini->onContactEnd || ini->onSensorEnter ||
+        ini->onSensorExit || ini->onDestroy);
 }
 
 void GxFreeTarget(GxEvent* e) {
@@ -1,7 +1,7 @@
 #include "../Graphics/GxGraphics.h"
 #include "../Scene/GxScene.h"
 #include "../Array/GxArray.h"
-#include "../Quadtree/GxQuadtree.h"
+#include "../Broadphase/GxBroadphase.h"
 #include "../Element/GxElement.h"
 #include "../Renderable/GxRenderable.h"
 #include "../Folder/GxFolder.h"
@@ -10,7 +10,8 @@
 
 typedef struct GxGraphics {
 	GxScene* scene;
-	GxQtree* rtree;
+	GxBroadphase* rtree;
+	GxElemBuffer found; //relative elements the camera query found
 	GxArray* absolute;
 	GxArray* renderables;	
 }GxGraphics;
@@ -21,7 +22,8 @@ GxGraphics* GxCreateGraphics_(GxScene* scene){
 	self->scene = scene;
 	GxSize size = GxSceneGetSize(scene);
 	int length = size.w > size.h ? size.w : size.h ;	
-	self->rtree = GxCreateQtree_(NULL, (SDL_Rect) { 0, 0, length, length }, "graphical");	
+	self->rtree = GxCreateBroadphase_(scene, (SDL_Rect) { 0, 0, length, length });	
+	self->found = (GxElemBuffer) { NULL, 0, 0 };
 	self->absolute = GxCreateArray();
 	self->renderables = GxCreateArray();
 	return self;
@@ -29,8 +31,8 @@ GxGraphics* GxCreateGraphics_(GxScene* scene){
 
 void GxDestroyGraphics_(GxGraphics* self) {
 	if (self) {
-		void GxDestroyQtree_(GxQtree* self);
-		GxDestroyQtree_(self->rtree);
+		GxDestroyBroadphase_(self->rtree);
+		GxElemBufferFree_(&self->found);
 		GxDestroyArray(self->absolute);
 		GxDestroyArray(self->renderables);	
 		free(self);
@@ -39,26 +41,30 @@ void GxDestroyGraphics_(GxGraphics* self) {
 
 void GxGraphicsInsertElement_(GxGraphics* self, GxElement* element) {	
 	if (GxElemIsRenderable(element)) {
-		if(GxElemHasRelativePosition(element)) GxQtreeInsert_(self->rtree, element);
+		if(GxElemHasRelativePosition(element)) GxBroadphaseInsert_(self->rtree, element);
 		else if(GxElemHasAbsolutePosition(element)) GxArrayPush(self->absolute, element, NULL);
 	}
 }
 
 void GxGraphicsUpdatePosition_(GxGraphics* self, GxElement* element, SDL_Rect previousPos) {	
 	if (GxElemHasRelativePosition(element)) {
-		GxQtreeUpdate_(self->rtree, element, previousPos);
+		GxBroadphaseUpdate_(self->rtree, element, previousPos);
 	}
 }
 
 void GxGraphicsRemoveElement_(GxGraphics* self, GxElement* element) {	
 	if (GxElemIsRenderable(element)) {
-		if(GxElemHasRelativePosition(element)) GxQtreeRemove_(self->rtree, element);
+		if(GxElemHasRelativePosition(element)) GxBroadphaseRemove_(self->rtree, element);
 		else if(GxElemHasAbsolutePosition(element)) GxArrayRemoveByValue(self->absolute, element);
 	}
 }
 
-static inline void fillRenderables_(GxElement* element) {
-	GxGraphics* graphics = GxSceneGetGraphics(GxElemGetScene(element));
+void GxGraphicsRebalance_(GxGraphics* self) {
+	GxBroadphaseRebalance_(self->rtree);
+}
+
+static void fillRenderables_(GxElement* element, void* context) {
+	GxGraphics* graphics = context;
 	if (!GxElemIsHidden(element)) {
 		GxArrayPush(graphics->renderables, element, NULL);
 	}
@@ -88,7 +94,7 @@ void GxGraphicsUpdate_(GxGraphics* self) {
 
 	//fill with relative elements
 	const SDL_Rect* area = GxElemGetPosition(GxSceneGetCamera(self->scene));	
-	GxQtreeIterate_(self->rtree, *area, fillRenderables_, true);
+	GxBroadphaseQuery_(self->rtree, *area, &self->found, fillRenderables_, self);
 
 	//sort
 	GxArraySort(self->renderables, (GxComp) compareIndexes_);
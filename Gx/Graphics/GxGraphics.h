@@ -10,5 +10,6 @@ void GxGraphicsInsertElement_(GxGraphics* self, GxElement* element);
 void GxGraphicsUpdatePosition_(GxGraphics* self, GxElement* element, SDL_Rect previousPos);
 void GxGraphicsRemoveElement_(GxGraphics* self, GxElement* element);
 void GxGraphicsUpdate_(GxGraphics* self);
+void GxGraphicsRebalance_(GxGraphics* self);
 
 #endif // !GX_GRAPHICS_H
@@ -0,0 +1,348 @@
+#include "../Utilities/GxUtil.h"
+#include "../Grid/GxGrid.h"
+#include "../Element/GxElement.h"
+#include "../RigidBody/GxRigidBody.h"
+#include <string.h>
+#include <stdlib.h>
+
+//... type
+typedef struct GridEntry {
+	GxElement* elem;
+	//position and collision filter cached from the element, so queries do not touch it
+	SDL_Rect pos;
+	Uint32 cmask;
+	Uint32 layer; //layer bit
+	int x, y; //first cell the element covers
+} GridEntry;
+
+//cells only leave the table in a rebalance, so it needs no tombstones and an emptied
+//cell keeps its array for the next element
+typedef struct GridCell {
+	int x, y;
+	GridEntry* entries;
+	int size;
+	int capacity;
+	bool used;
+} GridCell;
+
+typedef struct GridRange {
+	int x0, y0, x1, y1; //inclusive
+} GridRange;
+
+typedef struct GxGrid {
+	SDL_Rect pos;
+	int cellSize;
+	GridCell* cells; //open addressing, the capacity is a power of two
+	Uint32 ncells;
+	Uint32 ccells;
+	Uint64 allocations; //growths since creation, for the stats
+} GxGrid;
+
+//static
+static const Uint32 kMinCells = 256;
+static const int kCellCapacity = 8;
+
+GxGrid* GxCreateGrid_(SDL_Rect pos, int cellSize) {
+	GxAssertInvalidArgument(cellSize > 0);
+	GxGrid* self = malloc(sizeof(GxGrid));
+	GxAssertAllocationFailure(self);
+	self->pos = pos;
+	self->cellSize = cellSize;
+	self->ncells = 0;
+	self->ccells = kMinCells;
+	self->allocations = 0;
+	self->cells = calloc(self->ccells, sizeof(GridCell));
+	GxAssertAllocationFailure(self->cells);
+	return self;
+}
+
+void GxDestroyGrid_(GxGrid* self) {
+	if (self) {
+		for (Uint32 i = 0; i < self->ccells; i++) free(self->cells[i].entries);
+		free(self->cells);
+		free(self);
+	}
+}
+
+//... RANGES
+static inline int gridCoord(const GxGrid* self, int v) {
+	//rounds down, for negative coordinates too
+	return v >= 0 ? v / self->cellSize : -((-v - 1) / self->cellSize) - 1;
+}
+
+static inline bool gridRange(const GxGrid* self, const SDL_Rect* pos, GridRange* range) {
+	//empty rects cover no cell, as they intersect nothing
+	if (pos->w <= 0 || pos->h <= 0) return false;
+	range->x0 = gridCoord(self, pos->x);
+	range->y0 = gridCoord(self, pos->y);
+	range->x1 = gridCoord(self, pos->x + pos->w - 1);
+	range->y1 = gridCoord(self, pos->y + pos->h - 1);
+	return true;
+}
+
+static inline bool rangeHas(const GridRange* range, int x, int y) {
+	return x >= range->x0 && x <= range->x1 && y >= range->y0 && y <= range->y1;
+}
+
+static inline bool rectsIntersect(const SDL_Rect* a, const SDL_Rect* b) {
+	//same test as SDL_HasIntersection, without the call
+	return a->w > 0 && a->h > 0 && b->w > 0 && b->h > 0 &&
+		a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+//... ENTRIES
+static inline GridEntry createEntry(const GxGrid* self, GxElement* elem) {
+	const SDL_Rect* pos = GxElemGetPosition(elem);
+	GridEntry entry = { elem, *pos, 0, 0, gridCoord(self, pos->x), gridCoord(self, pos->y) };
+	if (GxElemIsPhysical(elem)) {
+		entry.cmask = GxElemGetCmask(elem);
+		entry.layer = 1u << GxElemGetLayer_(elem);
+	}
+	return entry;
+}
+
+static inline bool entryPasses(const GridEntry* entry, const GxBroadphaseFilter* filter) {
+	return !filter || ((entry->cmask & filter->cmask) && (entry->layer & filter->layers));
+}
+
+static inline int cellFind(const GridCell* cell, GxElement* elem) {
+	for (int i = 0; i < cell->size; i++) {
+		if (cell->entries[i].elem == elem) return i;
+	}
+	return -1;
+}
+
+static inline void cellPush(GxGrid* self, GridCell* cell, const GridEntry* entry) {
+	if (cell->size == cell->capacity) {
+		cell->capacity = cell->capacity ? cell->capacity * 2 : kCellCapacity;
+		cell->entries = realloc(cell->entries, cell->capacity * sizeof(GridEntry));
+		GxAssertAllocationFailure(cell->entries);
+		self->allocations++;
+	}
+	cell->entries[cell->size++] = *entry;
+}
+
+static inline void cellErase(GridCell* cell, int i) {
+	//keeps the order, as the quadtree does
+	memmove(&cell->entries[i], &cell->entries[i + 1], (cell->size - i - 1) * sizeof(GridEntry));
+	cell->size--;
+}
+
+//... TABLE
+static inline Uint32 gridHash(int x, int y) {
+	return (Uint32) x * 73856093u ^ (Uint32) y * 19349663u;
+}
+
+static inline GridCell* gridFind(const GxGrid* self, int x, int y) {
+	Uint32 mask = self->ccells - 1;
+	for (Uint32 i = gridHash(x, y) & mask; self->cells[i].used; i = (i + 1) & mask) {
+		if (self->cells[i].x == x && self->cells[i].y == y) return &self->cells[i];
+	}
+	return NULL;
+}
+
+static void gridRehash(GxGrid* self, Uint32 capacity, bool prune) {
+	//a prune also drops the empty cells with their arrays
+	GridCell* cells = self->cells;
+	Uint32 ccells = self->ccells;
+	self->cells = calloc(capacity, sizeof(GridCell));
+	GxAssertAllocationFailure(self->cells);
+	self->allocations++;
+	self->ccells = capacity;
+	self->ncells = 0;
+
+	Uint32 mask = capacity - 1;
+	for (Uint32 i = 0; i < ccells; i++) {
+		if (!cells[i].used) continue;
+		if (prune && !cells[i].size) {
+			free(cells[i].entries);
+			continue;
+		}
+		Uint32 j = gridHash(cells[i].x, cells[i].y) & mask;
+		while (self->cells[j].used) j = (j + 1) & mask;
+		self->cells[j] = cells[i];
+		self->ncells++;
+	}
+	free(cells);
+}
+
+static inline GridCell* gridFetch(GxGrid* self, int x, int y) {
+	//finds the cell or creates it, the table may move
+	GridCell* cell = gridFind(self, x, y);
+	if (cell) return cell;
+	if ((self->ncells + 1) * 2 > self->ccells) gridRehash(self, self->ccells * 2, false);
+
+	Uint32 mask = self->ccells - 1;
+	Uint32 i = gridHash(x, y) & mask;
+	while (self->cells[i].used) i = (i + 1) & mask;
+	cell = &self->cells[i];
+	cell->x = x;
+	cell->y = y;
+	cell->used = true;
+	self->ncells++;
+	return cell;
+}
+
+static inline GridCell* gridNext(const GxGrid* self, const GridRange* range, Uint32* cursor) {
+	//walks the cells of a range, or the whole table when it holds fewer cells than the range
+	Uint64 w = (Uint64) ((Sint64) range->x1 - range->x0 + 1);
+	Uint64 span = w * (Uint64) ((Sint64) range->y1 - range->y0 + 1);
+	if (span > self->ncells) {
+		while (*cursor < self->ccells) {
+			GridCell* cell = &self->cells[(*cursor)++];
+			if (cell->used && rangeHas(range, cell->x, cell->y)) return cell;
+		}
+		return NULL;
+	}
+	while (*cursor < span) {
+		int x = range->x0 + (int) (*cursor % w);
+		int y = range->y0 + (int) (*cursor / w);
+		(*cursor)++;
+		GridCell* cell = gridFind(self, x, y);
+		if (cell) return cell;
+	}
+	return NULL;
+}
+
+//acessors
+SDL_Rect GxGridGetPosition_(GxGrid* self) {
+	return self->pos;
+}
+
+GxBroadphaseStats GxGridGetStats_(GxGrid* self) {
+	GxBroadphaseStats stats = { self->ncells, 0, 0, 0, self->allocations };
+	for (Uint32 i = 0; i < self->ccells; i++) {
+		if (!self->cells[i].size) continue;
+		stats.leaves++;
+		stats.entries += (Uint32) self->cells[i].size;
+	}
+	return stats;
+}
+
+//methods
+void GxGridInsert_(GxGrid* self, GxElement* element) {
+	GridEntry entry = createEntry(self, element);
+	GridRange range;
+	if (!gridRange(self, &entry.pos, &range)) return;
+	for (int y = range.y0; y <= range.y1; y++) {
+		for (int x = range.x0; x <= range.x1; x++) {
+			GridCell* cell = gridFetch(self, x, y);
+			if (cellFind(cell, element) < 0) cellPush(self, cell, &entry);
+		}
+	}
+}
+
+void GxGridRemove_(GxGrid* self, GxElement* element) {
+	GridRange range;
+	if (!gridRange(self, GxElemGetPosition(element), &range)) return;
+	for (int y = range.y0; y <= range.y1; y++) {
+		for (int x = range.x0; x <= range.x1; x++) {
+			GridCell* cell = gridFind(self, x, y);
+			int i = cell ? cellFind(cell, element) : -1;
+			if (i >= 0) cellErase(cell, i);
+		}
+	}
+}
+
+void GxGridUpdate_(GxGrid* self, GxElement* element, SDL_Rect previous) {
+	GridEntry entry = createEntry(self, element);
+	GridRange from = { 0 }, to = { 0 };
+	bool had = gridRange(self, &previous, &from);
+	bool has = gridRange(self, &entry.pos, &to);
+
+	//the cells both ranges cover only refresh the entry, the others lose or gain it.
+	//Entries leave first, since creating cells may move the table
+	if (had) {
+		for (int y = from.y0; y <= from.y1; y++) {
+			for (int x = from.x0; x <= from.x1; x++) {
+				GridCell* cell = gridFind(self, x, y);
+				int i = cell ? cellFind(cell, element) : -1;
+				if (i < 0) continue;
+				if (has && rangeHas(&to, x, y)) cell->entries[i] = entry;
+				else cellErase(cell, i);
+			}
+		}
+	}
+	if (has) {
+		for (int y = to.y0; y <= to.y1; y++) {
+			for (int x = to.x0; x <= to.x1; x++) {
+				if (had && rangeHas(&from, x, y)) continue;
+				GridCell* cell = gridFetch(self, x, y);
+				if (cellFind(cell, element) < 0) cellPush(self, cell, &entry);
+			}
+		}
+	}
+}
+
+void GxGridRefresh_(GxGrid* self, GxElement* element) {
+	GridEntry entry = createEntry(self, element);
+	GridRange range;
+	if (!gridRange(self, &entry.pos, &range)) return;
+	for (int y = range.y0; y <= range.y1; y++) {
+		for (int x = range.x0; x <= range.x1; x++) {
+			GridCell* cell = gridFind(self, x, y);
+			int i = cell ? cellFind(cell, element) : -1;
+			if (i >= 0) cell->entries[i] = entry;
+		}
+	}
+}
+
+void GxGridRebalance_(GxGrid* self) {
+	//drops the empty cells and shrinks the table to what is left
+	Uint32 used = 0;
+	for (Uint32 i = 0; i < self->ccells; i++) {
+		if (self->cells[i].size) used++;
+	}
+	Uint32 capacity = kMinCells;
+	while (capacity < used * 2) capacity *= 2;
+	gridRehash(self, capacity, true);
+}
+
+static void gridCollect(const GxGrid* self, const SDL_Rect* area, const GxBroadphaseFilter* filter,
+	GxElemBuffer* out)
+{
+	//an element covering several cells is only reported from the first one the area also
+	//covers, so results come without duplicates
+	GridRange range;
+	if (!gridRange(self, area, &range)) return;
+	Uint32 cursor = 0;
+	for (GridCell* cell = gridNext(self, &range, &cursor); cell; cell = gridNext(self, &range, &cursor)) {
+		for (int i = 0; i < cell->size; i++) {
+			const GridEntry* entry = &cell->entries[i];
+			if (cell->x != (entry->x > range.x0 ? entry->x : range.x0)) continue;
+			if (cell->y != (entry->y > range.y0 ? entry->y : range.y0)) continue;
+			if (!entryPasses(entry, filter) || !rectsIntersect(&entry->pos, area)) continue;
+			GxElemBufferPush_(out, entry->elem);
+		}
+	}
+}
+
+void GxGridCollect_(GxGrid* self, SDL_Rect area, GxElemBuffer* out) {
+	gridCollect(self, &area, NULL, out);
+}
+
+void GxGridCollectFiltered_(GxGrid* self, SDL_Rect area, GxBroadphaseFilter filter, GxElemBuffer* out) {
+	gridCollect(self, &area, &filter, out);
+}
+
+void GxGridCollectSegment_(GxGrid* self, SDL_Point from, SDL_Point to,
+	GxBroadphaseFilter filter, GxElemBuffer* out)
+{
+	//like GxGridCollectFiltered_, but only reads the cells the segment crosses and leaves
+	//deduplication to the caller
+	SDL_Rect box = {
+		from.x < to.x ? from.x : to.x, from.y < to.y ? from.y : to.y,
+		abs(to.x - from.x) + 1, abs(to.y - from.y) + 1
+	};
+	GridRange range;
+	gridRange(self, &box, &range);
+	Uint32 cursor = 0;
+	for (GridCell* cell = gridNext(self, &range, &cursor); cell; cell = gridNext(self, &range, &cursor)) {
+		SDL_Rect pos = { cell->x * self->cellSize, cell->y * self->cellSize, self->cellSize, self->cellSize };
+		int x1 = from.x, y1 = from.y, x2 = to.x, y2 = to.y;
+		if (!SDL_IntersectRectAndLine(&pos, &x1, &y1, &x2, &y2)) continue;
+		for (int i = 0; i < cell->size; i++) {
+			if (entryPasses(&cell->entries[i], &filter)) GxElemBufferPush_(out, cell->entries[i].elem);
+		}
+	}
+}
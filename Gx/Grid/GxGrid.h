@@ -0,0 +1,25 @@
+#ifndef GX_GRID_H
+#define GX_GRID_H
+#include "../Utilities/GxUtil.h"
+#include "../Broadphase/GxBroadphase.h"
+
+//uniform grid whose cells live in a hash table, so it is unbounded and only the cells
+//holding elements take memory
+typedef struct GxGrid GxGrid;
+
+GxGrid* GxCreateGrid_(SDL_Rect pos, int cellSize);
+void GxDestroyGrid_(GxGrid* self);
+SDL_Rect GxGridGetPosition_(GxGrid* self);
+GxBroadphaseStats GxGridGetStats_(GxGrid* self);
+void GxGridInsert_(GxGrid* self, GxElement* element);
+void GxGridRemove_(GxGrid* self, GxElement* element);
+void GxGridUpdate_(GxGrid* self, GxElement* element, SDL_Rect previous);
+void GxGridRefresh_(GxGrid* self, GxElement* element);
+void GxGridRebalance_(GxGrid* self);
+void GxGridCollect_(GxGrid* self, SDL_Rect area, GxElemBuffer* out);
+void GxGridCollectFiltered_(GxGrid* self, SDL_Rect area, GxBroadphaseFilter filter, GxElemBuffer* out);
+void GxGridCollectSegment_(GxGrid* self, SDL_Point from, SDL_Point to,
+	GxBroadphaseFilter filter, GxElemBuffer* out
+);
+
+#endif // !GX_GRID_H
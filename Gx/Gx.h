@@ -19,6 +19,8 @@ typedef GxResponse Response;
 typedef GxScene Scene;
 typedef GxElement Element;
 typedef GxContact Contact;
+typedef GxRayHit RayHit;
+typedef GxSnapshot Snapshot;
 typedef GxData Data;
 typedef GxElemID ElemID;
 
@@ -12,8 +12,19 @@ typedef struct GxIni {
 	
 	//scene
 	GxSize size;
-	int gravity;
+	int gravity; //velocity gained per second
 	const char* folders;
+	//fixed ticks per second, 0 ticks once per frame. Velocities are pixels per tick
+	//and timeouts count ticks at 60 ticks per second, other rates scale them
+	int tickRate;
+	int maxTicks;
+	const SDL_Rect* simArea;
+	int simMargin; //0 keeps the default, -1 simulates the area without a margin
+	int farRate;
+	bool batchContacts;
+	bool looseTrees;
+	int broadphase;
+	int cellSize;
 
 	//tilemap
 	int* sequence;
@@ -46,6 +57,7 @@ typedef struct GxIni {
 	//body	
 	GxVector velocity;	
 	bool friction;
+	const char* layer;
 
 	//callbacks
 	void* target;
@@ -64,6 +76,8 @@ typedef struct GxIni {
 	GxHandler onPreContact;
 	GxHandler onContactBegin;
 	GxHandler onContactEnd;
+	GxHandler onSensorEnter;
+	GxHandler onSensorExit; //other is NULL when it was removed, a removed element gets no exit
 	GxHandler onElemRemove;
 } GxIni;
 
@@ -110,6 +110,19 @@ void* GxListNext(GxList* self) {
 	return NULL;
 }
 
+//reentrant iteration: the cursor is kept by the caller, so the list is only read
+void* GxListIterBegin(GxList* self, void** cursor) {
+	ListNode* node = self ? self->first : NULL;
+	*cursor = node;
+	return node ? node->value : NULL;
+}
+
+void* GxListIterNext(void** cursor) {
+	ListNode* node = *cursor ? ((ListNode*) *cursor)->next : NULL;
+	*cursor = node;
+	return node ? node->value : NULL;
+}
+
 void GxListPush(GxList* self, void* value, GxDestructor dtor) {
 	ListNode* node = createNode(value, dtor);	
 	if (self->last) {
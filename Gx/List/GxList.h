@@ -17,6 +17,8 @@ void* GxListAt(GxList* self, int index);
 bool GxListContains(GxList* self, void* value);
 void* GxListBegin(GxList* self);
 void* GxListNext(GxList* self);
+void* GxListIterBegin(GxList* self, void** cursor);
+void* GxListIterNext(void** cursor);
 void GxListPush(GxList* self, void* value, GxDestructor dtor);
 void GxListInsert(GxList* self, int index, void* value, GxDestructor dtor);
 bool GxListReplace(GxList* self, void* oldValue, void* newValue, GxDestructor dtor);
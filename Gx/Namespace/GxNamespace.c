@@ -12,6 +12,7 @@
 #include "../Button/GxButton.h"
 #include "../Folder/GxFolder.h"
 #include "../Tilemap/GxTilemap.h"
+#include "../Snapshot/GxSnapshot.h"
 
 const GxAppNamespace GxAppNamespaceInstance = {
 	.create = GxCreateApp,
@@ -35,6 +36,8 @@ const GxAppNamespace GxAppNamespaceInstance = {
 		.PRE_CONTACT = GxEventPreContact,
 		.CONTACT_BEGIN = GxEventContactBegin,
 		.CONTACT_END = GxEventContactEnd,
+		.SENSOR_ENTER = GxEventSensorEnter,
+		.SENSOR_EXIT = GxEventSensorExit,
 		.TIMEOUT = GxEventTimeout,
 		.DESTROY = GxEventOnDestroy,
 		.ELEM_REMOVAL = GxEventOnElemRemoval,
@@ -108,6 +111,8 @@ const GxElemNamespace GxElemNamespaceInstance = {
 	
 	.create = GxCreateElement,	
 	.createTilemap = GxCreateTileMap,	
+	.isTileSolid = GxTilemapIsSolid,
+	.setTileSolid = GxTilemapSetSolid,
 	.remove = GxElemRemove,
 	.getTarget = GxElemGetTarget,	
 	.addRequestHandler = GxElemAddRequestHandler,
@@ -123,14 +128,19 @@ const GxElemNamespace GxElemNamespaceInstance = {
 	.isRenderable = GxElemIsRenderable,
 	.hasDynamicBody = GxElemHasDynamicBody,	
 	.hasFixedBody = GxElemHasFixedBody,
+	.isSensor = GxElemIsSensor,
 	.hasRelativePosition = GxElemHasRelativePosition,
 	.hasAbsolutePosition = GxElemHasAbsolutePosition,
 	.setChild = GxElemSetChild,
 	.getChild = GxElemGetChild,	
 	//...body
 	.isOnGround = GxElemIsOnGround,
+	.isSleeping = GxElemIsSleeping,
+	.wake = GxElemWake,
 	.getCmask = GxElemGetCmask,
 	.setCmask = GxElemSetCmask,
+	.getLayer = GxElemGetLayer,
+	.setLayer = GxElemSetLayer,
 	.getPreference = GxElemGetPreference,
 	.setPreference = GxElemSetPreference,
 	.hasFriction = GxElemHasFriction,
@@ -150,6 +160,7 @@ const GxElemNamespace GxElemNamespaceInstance = {
 	.getMaxgvel = GxElemGetMaxgvel,
 	.setMaxgvel = GxElemSetMaxgvel,
 	.getContacts = GxElemGetContacts,
+	.nextContact = GxElemNextContact,
 	.move = GxElemMove,
 	.moveTo = GxElemMoveTo,
 	//renderable	
@@ -194,6 +205,9 @@ const GxElemNamespace GxElemNamespaceInstance = {
 	.RELATIVE = GxElemRelative,	
 	.FIXED = GxElemFixed,
 	.DYNAMIC = GxElemDynamic,
+	.GRID = GxElemGrid,
+	.MERGED = GxElemMerged,
+	.SENSOR = GxElemSensor,
 	.FORWARD = GxElemForward,
 	.BACKWARD = GxElemBackward,
 };
@@ -286,11 +300,36 @@ const GxSceneNamespace GxSceneNamespaceInstance = {
 	.getElem = GxSceneGetElement,
 	.getGravity = GxSceneGetGravity,
 	.hasGravity = GxSceneHasGravity,
+	.getTickRate = GxSceneGetTickRate,
+	.getAlpha = GxSceneGetAlpha,
+	.getSimulationArea = GxSceneGetSimulationArea,
+	.getSimulationMargin = GxSceneGetSimulationMargin,
+	.getFarRate = GxSceneGetFarRate,
+	.isBatchingContacts = GxSceneIsBatchingContacts,
+	.hasLooseTrees = GxSceneHasLooseTrees,
+	.getBroadphase = GxSceneGetBroadphase,
+	.getCellSize = GxSceneGetCellSize,
 	.getCamera = GxSceneGetCamera,
+	.raycast = GxSceneRaycast,
+	.raycastAll = GxSceneRaycastAll,
+	.queryRect = GxSceneQueryRect,
+	.queryPoint = GxSceneQueryPoint,
+	.getLayer = GxSceneGetLayer,
+	.getLayerName = GxSceneGetLayerName,
+	.setLayerCollision = GxSceneSetLayerCollision,
+	.layersCollide = GxSceneLayersCollide,
 	.pause = GxScenePause,
 	.resume = GxSceneResume,
 	.setGravity = GxSceneSetGravity,
+	.setSimulationArea = GxSceneSetSimulationArea,
+	.setSimulationMargin = GxSceneSetSimulationMargin,
+	.setFarRate = GxSceneSetFarRate,
+	.setBatchContacts = GxSceneSetBatchContacts,
 	.setTimeout = GxSceneSetTimeout,
+	.rebalance = GxSceneRebalance,
+	.saveSnapshot = GxSceneSaveSnapshot,
+	.restoreSnapshot = GxSceneRestoreSnapshot,
+	.freeSnapshot = GxFreeSnapshot,
 	.addEventListener = GxSceneAddEventListener,
 	.removeEventListener = GxSceneRemoveEventListener,
 	.status = &(const struct GxStatusNamespace){
@@ -301,6 +340,10 @@ const GxSceneNamespace GxSceneNamespaceInstance = {
 		.PAUSED = GxStatusPaused,
 		.UNLOADING = GxStatusLoading,
 	},	
+	.broadphase = &(const struct GxBroadphaseNamespace){
+		.QUADTREE = GxBroadphaseQuadtree,
+		.GRID = GxBroadphaseGrid,
+	},
 };
 
 
@@ -24,6 +24,8 @@ struct GxEventNamespace {
 	const int PRE_CONTACT;
 	const int CONTACT_BEGIN;
 	const int CONTACT_END;
+	const int SENSOR_ENTER;
+	const int SENSOR_EXIT;
 	const int TIMEOUT;
 	const int DESTROY;
 	const int ELEM_REMOVAL;
@@ -107,6 +109,8 @@ typedef struct GxElemNamespace {
 	//...Element
 	GxElement* (*create)(const GxIni* ini);	
 	GxElement* (*createTilemap)(const char* tilePath, const GxIni* ini);	
+	bool (*isTileSolid)(GxElement* self, int row, int col);
+	void (*setTileSolid)(GxElement* self, int row, int col, bool solid);
 	void (*remove)(GxElement* self);	
 	void* (*getTarget)(GxElement* self);
 	Uint32 (*getID)(GxElement* self);
@@ -127,6 +131,7 @@ typedef struct GxElemNamespace {
 	bool (*isRenderable)(GxElement* self);
 	bool (*hasDynamicBody)(GxElement* self);
 	bool (*hasFixedBody)(GxElement* self);
+	bool (*isSensor)(GxElement* self);
 	bool (*hasRelativePosition)(GxElement* self);
 	bool (*hasAbsolutePosition)(GxElement* self);	
 	
@@ -135,9 +140,13 @@ typedef struct GxElemNamespace {
 	
 	//...RigidBody
 	bool (*isOnGround)(GxElement* self);
+	bool (*isSleeping)(GxElement* self);
+	void (*wake)(GxElement* self);
 
 	Uint32 (*getCmask)(GxElement* self);
 	void (*setCmask)(GxElement* self, Uint32 mask);
+	const char* (*getLayer)(GxElement* self);
+	void (*setLayer)(GxElement* self, const char* layer);
 
 	int (*getPreference)(GxElement* self);
 	void (*setPreference)(GxElement* self, int value);
@@ -168,6 +177,7 @@ typedef struct GxElemNamespace {
 	void (*setMaxgvel)(GxElement* self, int value);
 
 	GxArray* (*getContacts)(GxElement* self, int types);	
+	GxContact* (*nextContact)(GxElement* self, int types, Uint32* cursor);
 
 	GxVector (*move)(GxElement* self, GxVector vector, bool force);
 	void (*moveTo)(GxElement* self, GxPoint pos, bool force);
@@ -230,6 +240,9 @@ typedef struct GxElemNamespace {
 	const int RELATIVE;
 	const int FIXED;
 	const int DYNAMIC;
+	const int GRID;
+	const int MERGED;
+	const int SENSOR;
 	const int FORWARD;
 	const int BACKWARD;
 
@@ -329,6 +342,11 @@ struct GxStatusNamespace {
 	const int UNLOADING;
 };
 
+struct GxBroadphaseNamespace {
+	const int QUADTREE;
+	const int GRID;
+};
+
 typedef struct GxSceneNamespace {
 		
 	GxScene* (*create)(const GxIni* ini);	
@@ -342,14 +360,40 @@ typedef struct GxSceneNamespace {
 	GxElement* (*getElem)(GxScene* self, Uint32 id);
 	int (*getGravity)(GxScene* self);
 	bool (*hasGravity)(GxScene* self);
+	int (*getTickRate)(GxScene* self);
+	double (*getAlpha)(GxScene* self);
+	SDL_Rect (*getSimulationArea)(GxScene* self);
+	int (*getSimulationMargin)(GxScene* self);
+	int (*getFarRate)(GxScene* self);
+	bool (*isBatchingContacts)(GxScene* self);
+	bool (*hasLooseTrees)(GxScene* self);
+	int (*getBroadphase)(GxScene* self);
+	int (*getCellSize)(GxScene* self);
 	GxElement* (*getCamera)(GxScene* self);
+	bool (*raycast)(GxScene* self, SDL_Point from, SDL_Point to, Uint32 cmask, GxRayHit* hit);
+	int (*raycastAll)(GxScene* self, SDL_Point from, SDL_Point to, Uint32 cmask, GxRayHit* hits, int capacity);
+	int (*queryRect)(GxScene* self, SDL_Rect area, Uint32 cmask, GxElement** elems, int capacity);
+	int (*queryPoint)(GxScene* self, SDL_Point point, Uint32 cmask, GxElement** elems, int capacity);
+	Uint32 (*getLayer)(GxScene* self, const char* name);
+	const char* (*getLayerName)(GxScene* self, Uint32 layer);
+	void (*setLayerCollision)(GxScene* self, const char* layer, const char* other, bool collide);
+	bool (*layersCollide)(GxScene* self, const char* layer, const char* other);
 	void (*pause)(GxScene* self);
 	void (*resume)(GxScene* self);
 	void (*setGravity)(GxScene* self, int gravity);
+	void (*setSimulationArea)(GxScene* self, const SDL_Rect* area);
+	void (*setSimulationMargin)(GxScene* self, int margin);
+	void (*setFarRate)(GxScene* self, int rate);
+	void (*setBatchContacts)(GxScene* self, bool value);
 	void (*setTimeout)(GxScene* self, int interval, GxHandler callback, void* target);	
+	void (*rebalance)(GxScene* self);
+	void (*saveSnapshot)(GxScene* self, GxSnapshot* snapshot);
+	bool (*restoreSnapshot)(GxScene* self, const GxSnapshot* snapshot);
+	void (*freeSnapshot)(GxSnapshot* snapshot);
 	void (*addEventListener)(GxScene* self, int type, GxHandler handler, void* target);
 	bool (*removeEventListener)(GxScene* self, int type, GxHandler handler, void* target);	
 	const struct GxStatusNamespace* status;
+	const struct GxBroadphaseNamespace* broadphase;
 }GxSceneNamespace;
 
 
@@ -1,30 +1,123 @@
 #include "../Utilities/GxUtil.h"
 #include "../Physics/GxPhysics.h"
-#include "../Quadtree/GxQuadtree.h"
+#include "../Broadphase/GxBroadphase.h"
+#include "../Snapshot/GxSnapshot.h"
 #include "../Scene/GxScene.h"
 #include "../Element/GxElement.h"
 #include "../RigidBody/GxRigidBody.h"
 #include "../Map/GxMap.h"
 #include "../Array/GxArray.h"
-#include "../List/GxList.h"
 #include <string.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include "../App/GxApp.h"
 
 
 
+//element ids, which stay valid after the element is removed
+typedef struct IdBuffer {
+	Uint32* ids;
+	Uint32 size;
+	Uint32 capacity;
+} IdBuffer;
+
+typedef struct SensorPair {
+	Uint32 sensor;
+	Uint32 body;
+} SensorPair;
+
+//a contact begin or end waiting for the end of the pass, copied since the contact may be gone
+typedef struct ContactEvent {
+	int type;
+	Uint32 colliding;
+	Uint32 collided;
+	Uint32 direction;
+	int amove;
+	bool prevented;
+} ContactEvent;
 
 typedef struct GxPhysics {
 	GxScene* scene;	
-	GxArray* contacts;
-	GxQtree* fixed;
-	GxQtree* dynamic;	
+	GxBroadphase* fixed;
+	GxBroadphase* dynamic;	
 
 	//buffers
 	SDL_Rect* walls;
-	GxArray* emdstack;
-	GxArray* mvstack;
-	GxArray* cntend;
+	struct EmData* emdata; //top of the movement data stack, which lives in the arena
+	GxElemBuffer cntend;
 	int depth;
+
+	//scratch memory of the moves, released when they return
+	struct ArenaBlock* arena;
+	struct ArenaBlock* ablock;
+
+	//contact pool
+	GxContact* cpool;
+	GxArray* cblocks;
+
+	//contact index, an open addressing set keyed by (colliding, collided, direction)
+	GxContact** ctable;
+	Uint32 csize;
+	Uint32 ccapacity;
+
+	//broadphase: bodies of the current pass (sorted by id) and their fixed tree candidates
+	GxElemBuffer bodies;
+	GxElemBuffer* candidates;
+	SDL_Rect* queries;
+	int* strides; //ticks each body covers in this pass, above 1 for the far tier
+	GxBroadphaseFilter* filters; //collision filters the candidates were queried with
+	Uint32 bcapacity;
+	GxElemBuffer* lqueries; //live query buffers, one per move depth
+	Uint32 lqcapacity;
+	GxElemBuffer* pqueries; //push solver query buffers, one per move depth
+	Uint32 pqcapacity;
+	Uint32 current;
+	Uint32 pass;
+	Uint32 version;
+	Sint32 gacc;
+	int margin;
+	int stride; //stride of the next top level move
+	SDL_Rect area;
+	int farRate;
+	bool resolving;
+	bool stale;
+	GxElement* forced; //element of a forced GxElemMove, it only collides with the force mask
+
+	//broadphase worker pool, created when a pass has enough bodies
+	SDL_Thread** workers;
+	int nworkers;
+	SDL_sem* wstart;
+	SDL_sem* wdone;
+	SDL_atomic_t wnext;
+	SDL_atomic_t wquit;
+
+	//spatial queries
+	GxElemBuffer squery;
+	GxRayHit* rhits;
+	Uint32 rhcapacity;
+
+	//sensors live in their own tree and keep the bodies inside them as sorted id pairs
+	GxBroadphase* sensors;
+	Uint32 nsensors;
+	IdBuffer smoved; //bodies that moved since the last sensor pass
+	IdBuffer sdirty; //sensors inserted or moved since then
+	SensorPair* spairs;
+	Uint32 nspairs;
+	Uint32 cspairs;
+	GxElemBuffer sfound;
+
+	//contact events queued while the scene batches them
+	ContactEvent* cevents;
+	Uint32 ncevents;
+	Uint32 ccevents;
+	bool batching;
+
+	//carrier graphs, stamped on the bodies they reach
+	Uint32 carry;
+	GxElement* carried; //rider the innermost graph is moving
+
+	GxPhysicsStats stats;
 } GxPhysics;
 
 typedef struct GxContact {
@@ -35,78 +128,340 @@ typedef struct GxContact {
 	int amove;
 	bool effective;
 	bool prevented;
+	GxContact* next; //next free contact in the pool
 } GxContact;
 
+typedef struct ArenaBlock {
+	struct ArenaBlock* next;
+	size_t capacity;
+	size_t used;
+	max_align_t data[];
+} ArenaBlock;
+
+typedef struct ArenaMark {
+	ArenaBlock* block;
+	size_t used;
+} ArenaMark;
+
+//contacts are allocated in blocks and recycled through GxPhysics->cpool
+static const Uint32 kContactBlock = 64;
+static const Uint32 kContactTableMin = 64; //must be a power of two
+
+//minimum size of a scratch arena block
+static const size_t kArenaBlock = 16384;
+
+//bodies per pass before the candidate queries are split across worker threads
+static const Uint32 kParallelMin = 256;
+static const int kBroadphaseChunk = 32;
+static const int kMaxWorkers = 15;
+
+//a forced move only collides with elements holding this bit
+static const Uint32 kForceMask = 1u << 31;
+
 //... Prototypes
 static inline void destroyContact(GxContact* self);
-static void physicsCheckGround(GxElement * other);
+static void physicsCheckGround(GxPhysics* physics, GxElement* other);
 
 //... Constructor and destructor
 GxPhysics* GxCreatePhysics_(GxScene* scene) {
 	GxPhysics* self = malloc(sizeof(GxPhysics));
 	GxAssertAllocationFailure(self);
 	self->scene = scene;	
-	self->contacts = GxCreateArray();
 	GxSize size = GxSceneGetSize(scene);
 	int length = size.w > size.h ? size.w + 2 : size.h + 2;		
-	self->dynamic = GxCreateQtree_(NULL, (SDL_Rect) { -1, -1, length, length }, "dynamic");
-	self->fixed = GxCreateQtree_(NULL, (SDL_Rect) { -1, -1, length, length }, "fixed");	
+	self->dynamic = GxCreateBroadphase_(scene, (SDL_Rect) { -1, -1, length, length });
+	self->fixed = GxCreateBroadphase_(scene, (SDL_Rect) { -1, -1, length, length });	
+	self->sensors = GxCreateBroadphase_(scene, (SDL_Rect) { -1, -1, length, length });
 
 	//buffers
 	self->walls = NULL;
-	self->emdstack = GxCreateArray();
-	self->mvstack = GxCreateArray();
-	self->cntend = GxCreateArray();
+	self->emdata = NULL;
+	self->cntend = (GxElemBuffer) { NULL, 0, 0 };
 	self->depth = 0;
+	self->arena = NULL;
+	self->ablock = NULL;
+
+	//contact pool
+	self->cpool = NULL;
+	self->cblocks = GxCreateArray();
+
+	//contact index
+	self->csize = 0;
+	self->ccapacity = kContactTableMin;
+	self->ctable = calloc(self->ccapacity, sizeof(GxContact*));
+	GxAssertAllocationFailure(self->ctable);
+
+	//broadphase
+	self->bodies = (GxElemBuffer) { NULL, 0, 0 };
+	self->candidates = NULL;
+	self->queries = NULL;
+	self->strides = NULL;
+	self->filters = NULL;
+	self->bcapacity = 0;
+	self->lqueries = NULL;
+	self->lqcapacity = 0;
+	self->pqueries = NULL;
+	self->pqcapacity = 0;
+	self->current = 0;
+	self->pass = 0;
+	self->version = 0;
+	self->gacc = 0;
+	self->margin = 0;
+	self->stride = 1;
+	self->area = (SDL_Rect) { 0, 0, 0, 0 };
+	self->farRate = 0;
+	self->resolving = false;
+	self->stale = false;
+	self->forced = NULL;
+	self->workers = NULL;
+	self->nworkers = 0;
+	self->wstart = NULL;
+	self->wdone = NULL;
+	SDL_AtomicSet(&self->wnext, 0);
+	SDL_AtomicSet(&self->wquit, 0);
+	self->squery = (GxElemBuffer) { NULL, 0, 0 };
+	self->rhits = NULL;
+	self->rhcapacity = 0;
+
+	//sensors
+	self->nsensors = 0;
+	self->smoved = (IdBuffer) { NULL, 0, 0 };
+	self->sdirty = (IdBuffer) { NULL, 0, 0 };
+	self->spairs = NULL;
+	self->nspairs = 0;
+	self->cspairs = 0;
+	self->sfound = (GxElemBuffer) { NULL, 0, 0 };
+	self->cevents = NULL;
+	self->ncevents = 0;
+	self->ccevents = 0;
+	self->batching = false;
+	self->carry = 0;
+	self->carried = NULL;
+	self->stats = (GxPhysicsStats) { 0 };
 	return self;
 }
 
 void GxDestroyPhysics_(GxPhysics* self) {		
-	if (self) {		
-		for (Uint32 i = 0; i < GxArraySize(self->contacts); i++){
-			GxContact* contact = GxArrayAt(self->contacts, i);			
-			destroyContact(contact);
+	if (self) {
+		//stop the broadphase workers
+		SDL_AtomicSet(&self->wquit, 1);
+		for (int i = 0; i < self->nworkers; i++) SDL_SemPost(self->wstart);
+		for (int i = 0; i < self->nworkers; i++) SDL_WaitThread(self->workers[i], NULL);
+		free(self->workers);
+		if (self->wstart) SDL_DestroySemaphore(self->wstart);
+		if (self->wdone) SDL_DestroySemaphore(self->wdone);
+
+		GxElemBufferFree_(&self->bodies);
+		for (Uint32 i = 0; i < self->bcapacity; i++) GxElemBufferFree_(&self->candidates[i]);
+		for (Uint32 i = 0; i < self->lqcapacity; i++) GxElemBufferFree_(&self->lqueries[i]);
+		for (Uint32 i = 0; i < self->pqcapacity; i++) GxElemBufferFree_(&self->pqueries[i]);
+		free(self->candidates);
+		free(self->queries);
+		free(self->strides);
+		free(self->filters);
+		GxElemBufferFree_(&self->squery);
+		free(self->rhits);
+		free(self->lqueries);
+		free(self->pqueries);
+		free(self->smoved.ids);
+		free(self->sdirty.ids);
+		free(self->spairs);
+		GxElemBufferFree_(&self->sfound);
+		free(self->cevents);
+
+		//contacts live in the pool blocks, so they are released all at once
+		free(self->ctable);
+		GxElemBufferFree_(&self->cntend);
+		for (ArenaBlock* block = self->arena, *next; block != NULL; block = next) {
+			next = block->next;
+			free(block);
 		}
-		GxDestroyArray(self->contacts);
-		GxDestroyArray(self->emdstack);
-		GxDestroyArray(self->mvstack);
-		GxDestroyArray(self->cntend);
-		GxDestroyQtree_(self->dynamic);
-		GxDestroyQtree_(self->fixed);
+		GxDestroyArray(self->cblocks);
+		GxDestroyBroadphase_(self->dynamic);
+		GxDestroyBroadphase_(self->fixed);
+		GxDestroyBroadphase_(self->sensors);
 		free(self);
 	}
 }
 
+//... SCRATCH ARENA
+//Blocks are kept once allocated, so after the first frames moving elements never calls the
+//allocator. Moves nest, so memory is released in stack order through marks.
+static inline size_t arenaAlign(size_t size) {
+	return (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+}
+
+static void* physicsArenaAlloc(GxPhysics* self, size_t size) {
+	size = arenaAlign(size);
+	ArenaBlock* block = self->ablock;
+	if (!block || block->used + size > block->capacity) {
+		//use the next block if it is big enough, otherwise put a new one in front of it
+		ArenaBlock* next = block ? block->next : self->arena;
+		if (!next || next->capacity < size) {
+			size_t capacity = size > kArenaBlock ? size : kArenaBlock;
+			ArenaBlock* created = malloc(sizeof(ArenaBlock) + capacity);
+			GxAssertAllocationFailure(created);
+			self->stats.allocations++;
+			created->capacity = capacity;
+			created->next = next;
+			if (block) block->next = created;
+			else self->arena = created;
+			next = created;
+		}
+		next->used = 0;
+		block = self->ablock = next;
+	}
+	void* ptr = (char*) block->data + block->used;
+	block->used += size;
+	return ptr;
+}
+
+static void* physicsArenaGrow(GxPhysics* self, void* ptr, size_t size, size_t capacity) {
+	//grows in place when ptr is the last allocation
+	ArenaBlock* block = self->ablock;
+	if (ptr && block && (char*) ptr + arenaAlign(size) == (char*) block->data + block->used &&
+		(char*) ptr + arenaAlign(capacity) <= (char*) block->data + block->capacity) 
+	{
+		block->used += arenaAlign(capacity) - arenaAlign(size);
+		return ptr;
+	}
+	void* grown = physicsArenaAlloc(self, capacity);
+	if (ptr) memcpy(grown, ptr, size);
+	return grown;
+}
+
+static inline ArenaMark physicsArenaMark(GxPhysics* self) {
+	return (ArenaMark) { self->ablock, self->ablock ? self->ablock->used : 0 };
+}
+
+static inline void physicsArenaRelease(GxPhysics* self, ArenaMark mark) {
+	self->ablock = mark.block;
+	if (mark.block) mark.block->used = mark.used;
+}
+
+//... CONTACT INDEX
+static inline Uint32 contactHash(GxElement* colliding, GxElement* collided, Uint32 direction) {
+	uint64_t hash = (uint64_t) (uintptr_t) colliding * 0x9E3779B97F4A7C15ull;
+	hash ^= (uint64_t) (uintptr_t) collided + 0x632BE59BD9B4E019ull + (hash << 6) + (hash >> 2);
+	hash ^= direction * 0xC2B2AE3D27D4EB4Full;
+	return (Uint32) (hash ^ (hash >> 32));
+}
+
+static inline bool contactIsEqual(GxContact* lhs, GxContact* rhs);
+
+static inline GxContact* physicsFindContact(GxPhysics* self, GxContact* contact) {
+	Uint32 mask = self->ccapacity - 1;
+	Uint32 i = contactHash(contact->colliding, contact->collided, contact->direction) & mask;
+	for (GxContact* entry = self->ctable[i]; entry != NULL; entry = self->ctable[i]) {
+		if (contactIsEqual(entry, contact)) return entry;
+		i = (i + 1) & mask;
+	}
+	return NULL;
+}
+
+static inline void physicsPlaceContact(GxContact** table, Uint32 capacity, GxContact* contact) {
+	Uint32 mask = capacity - 1;
+	Uint32 i = contactHash(contact->colliding, contact->collided, contact->direction) & mask;
+	while (table[i]) i = (i + 1) & mask;
+	table[i] = contact;
+}
+
+static inline void physicsIndexContact(GxPhysics* self, GxContact* contact) {
+	//keep the load factor under 1/2
+	if ((self->csize + 1) * 2 > self->ccapacity) {
+		Uint32 capacity = self->ccapacity * 2;
+		GxContact** table = calloc(capacity, sizeof(GxContact*));
+		GxAssertAllocationFailure(table);
+		self->stats.allocations++;
+		for (Uint32 i = 0; i < self->ccapacity; i++) {
+			if (self->ctable[i]) physicsPlaceContact(table, capacity, self->ctable[i]);
+		}
+		free(self->ctable);
+		self->ctable = table;
+		self->ccapacity = capacity;
+	}
+	physicsPlaceContact(self->ctable, self->ccapacity, contact);
+	self->csize++;
+}
+
+static inline void physicsUnindexContact(GxPhysics* self, GxContact* contact) {
+	Uint32 mask = self->ccapacity - 1;
+	Uint32 i = contactHash(contact->colliding, contact->collided, contact->direction) & mask;
+	while (self->ctable[i] && self->ctable[i] != contact) i = (i + 1) & mask;
+	if (!self->ctable[i]) return;
+	
+	//backward shift deletion, so lookups never need tombstones
+	Uint32 hole = i;
+	for (Uint32 j = (i + 1) & mask; self->ctable[j] != NULL; j = (j + 1) & mask) {
+		GxContact* entry = self->ctable[j];
+		Uint32 home = contactHash(entry->colliding, entry->collided, entry->direction) & mask;
+		if (((j - home) & mask) >= ((j - hole) & mask)) {
+			self->ctable[hole] = entry;
+			hole = j;
+		}
+	}
+	self->ctable[hole] = NULL;
+	self->csize--;
+}
+
 typedef struct EmData {
 	GxElement* self;
 	SDL_Rect trajetory;
 	SDL_Rect requestedPos;
 	SDL_Rect previousPos;
-	GxArray* contacts;
+	GxVector move;
+	GxContact** contacts;
+	Uint32 ncontacts;
+	Uint32 ccontacts;
+	GxElemBuffer* candidates;
+	struct EmData* prev;
 }EmData;
 
-static inline EmData* createEmData(GxElement* elem) {
-	EmData* self = malloc(sizeof(EmData));
-	GxAssertAllocationFailure(self);
+static inline EmData* createEmData(GxPhysics* physics, GxElement* elem, GxVector move) {
+	EmData* self = physicsArenaAlloc(physics, sizeof(EmData));
 	self->self = elem;
+	self->move = move;
 	self->requestedPos = self->previousPos = *GxElemGetPosition(elem);	
-	self->requestedPos.x = self->previousPos.x + GxElemGetVelx(elem);
-	self->requestedPos.y = self->previousPos.y + GxElemGetVely(elem);
+	self->requestedPos.x = self->previousPos.x + move.x;
+	self->requestedPos.y = self->previousPos.y + move.y;
 	SDL_UnionRect(&self->previousPos, &self->requestedPos, &self->trajetory);
 	self->contacts = NULL;
+	self->ncontacts = 0;
+	self->ccontacts = 0;
+	self->candidates = NULL;
+	self->prev = physics->emdata;
+	physics->emdata = self;
 	return self;
 }
 
-static inline void destroyEmData(EmData* self) {
-	if (self) {
-		GxDestroyArray(self->contacts);
-		free(self);
+static inline void emdataPushContact(GxPhysics* physics, EmData* self, GxContact* contact) {
+	if (self->ncontacts == self->ccontacts) {
+		Uint32 capacity = self->ccontacts ? self->ccontacts * 2 : 8;
+		self->contacts = physicsArenaGrow(physics, self->contacts, 
+			self->ccontacts * sizeof(GxContact*), capacity * sizeof(GxContact*));
+		self->ccontacts = capacity;
 	}
+	self->contacts[self->ncontacts++] = contact;
 }
 
-static inline GxContact* createContact(GxElement* self, GxElement* other, int amove, Uint32 direction) {
-	GxContact* contact = malloc(sizeof(GxContact));	
-	GxAssertAllocationFailure(contact);
+static inline void physicsGrowContactPool(GxPhysics* self) {
+	GxContact* block = malloc(sizeof(GxContact) * kContactBlock);
+	GxAssertAllocationFailure(block);
+	self->stats.allocations++;
+	GxArrayPush(self->cblocks, block, free);
+	for (Uint32 i = 0; i < kContactBlock; i++) {
+		block[i].hash = 0;
+		block[i].next = i + 1 < kContactBlock ? &block[i + 1] : self->cpool;
+	}
+	self->cpool = block;
+}
+
+static inline GxContact* createContact(GxPhysics* physics, GxElement* self, GxElement* other, int amove, Uint32 direction) {
+	if (!physics->cpool) physicsGrowContactPool(physics);
+	GxContact* contact = physics->cpool;
+	physics->cpool = contact->next;
+	physics->stats.contacts++;
+	contact->next = NULL;
 	contact->hash = GxHashContact_;
 	contact->colliding = self;
 	contact->collided = other;
@@ -118,205 +473,1161 @@ static inline GxContact* createContact(GxElement* self, GxElement* other, int am
 }
 
 static inline void destroyContact(GxContact* self) {
-	if (self) {
+	//a contact already back in the pool is ignored, pushing it twice would corrupt the pool
+	if (self && self->hash == GxHashContact_) {
 		GxScene* scene = GxElemGetScene(self->colliding);
+		GxPhysics* physics = GxSceneGetPhysics(scene);
 		if (self->effective && !GxSceneHasStatus(scene, GxStatusUnloading)) {			
 			elemRemoveContact_(self->colliding, self);
 			elemRemoveContact_(self->collided, self);
-			GxArrayRemoveByValue(GxSceneGetPhysics(scene)->contacts, self);
+			physicsUnindexContact(physics, self);
 		}
-		free(self);
+		//give the contact back to the pool
+		self->hash = 0;
+		self->effective = false;
+		self->next = physics->cpool;
+		physics->cpool = self;
 	}
 }
 
+//... CONTACT EVENTS
+//When the scene batches contacts, begin and end are queued during the pass and delivered after
+//it, once nothing is being resolved, so the handlers may move or remove elements freely.
+static inline void physicsContactEvent(GxPhysics* self, int type, GxContact* contact) {
+	if (!self->batching) {
+		if (type == GxEventContactBegin) GxSceneOnContactBegin_(self->scene, contact);
+		else GxSceneOnContactEnd_(self->scene, contact);
+		return;
+	}
+	if (self->ncevents == self->ccevents) {
+		self->ccevents = self->ccevents ? self->ccevents * 2 : 64;
+		self->cevents = realloc(self->cevents, self->ccevents * sizeof(ContactEvent));
+		GxAssertAllocationFailure(self->cevents);
+		self->stats.allocations++;
+	}
+	self->cevents[self->ncevents++] = (ContactEvent) {
+		.type = type,
+		.colliding = GxElemGetId(contact->colliding),
+		.collided = GxElemGetId(contact->collided),
+		.direction = contact->direction,
+		.amove = contact->amove,
+		.prevented = contact->prevented,
+	};
+}
+
+static void physicsDispatchContactEvents(GxPhysics* self) {
+	//events raised by the handlers themselves are delivered right away
+	self->batching = false;
+	for (Uint32 i = 0; i < self->ncevents; i++) {
+		ContactEvent* event = &self->cevents[i];
+		GxElement* colliding = GxSceneGetElement(self->scene, event->colliding);
+		GxElement* collided = GxSceneGetElement(self->scene, event->collided);
+		if (!colliding || !collided) continue;
+		GxContact contact = {
+			.hash = GxHashContact_,
+			.colliding = colliding,
+			.collided = collided,
+			.direction = event->direction,
+			.amove = event->amove,
+			.effective = true,
+			.prevented = event->prevented,
+		};
+		GxSceneDispatchContact_(self->scene, event->type, &contact);
+	}
+	self->ncevents = 0;
+}
+
 //... PHYSIC STATIC METHODS PROTOTYPES
 static inline GxVector physicsProcessMovementData(GxPhysics * self);
-static inline void physicsApplyGravity(GxPhysics * self, GxElement * elem);
+static inline void physicsApplyGravity(GxPhysics * self, GxElement * elem, int stride);
+static inline Sint32 physicsGravityStep(GxPhysics* self);
 static inline void physicsCheckContactEnd(GxPhysics* self, GxElement* element);
-static inline void physicsMoveElement_(GxElement* element);
+static inline GxVector physicsMoveElement_(GxPhysics* physics, GxElement* element);
 static inline bool physicsAddContact(GxPhysics* self, GxContact* contact);
-static inline void physicsCheckCollision(GxElement* other);
-static inline bool contactIsEqual(GxContact* lhs, GxContact* rhs);
+static inline void physicsCheckCollision(GxPhysics* physics, GxElement* other);
+
+//... BROADPHASE
+//A pass runs in three phases. First the dynamic bodies are gathered in id order and their
+//trajectories predicted. Then the fixed tree is queried for every body, in parallel, with the
+//trajectory inflated by a margin. Finally the bodies are resolved serially in id order, so the
+//outcome does not depend on the tree layout. A body only uses its precomputed candidates while
+//its actual trajectory still fits the query and no element travelled further than the margin;
+//otherwise it falls back to a live query.
+static inline SDL_Rect inflateRect(SDL_Rect rect, int amount) {
+	return (SDL_Rect) { rect.x - amount, rect.y - amount, rect.w + 2 * amount, rect.h + 2 * amount };
+}
+
+static inline bool rectContains(const SDL_Rect* outer, const SDL_Rect* inner) {
+	return inner->x >= outer->x && inner->y >= outer->y &&
+		inner->x + inner->w <= outer->x + outer->w && inner->y + inner->h <= outer->y + outer->h;
+}
+
+static inline void physicsReserveBodies(GxPhysics* self, Uint32 count) {
+	if (count <= self->bcapacity) return;
+	Uint32 capacity = self->bcapacity ? self->bcapacity : 64;
+	while (capacity < count) capacity *= 2;
+	self->candidates = realloc(self->candidates, capacity * sizeof(GxElemBuffer));
+	self->queries = realloc(self->queries, capacity * sizeof(SDL_Rect));
+	self->strides = realloc(self->strides, capacity * sizeof(int));
+	self->filters = realloc(self->filters, capacity * sizeof(GxBroadphaseFilter));
+	GxAssertAllocationFailure(self->candidates);
+	GxAssertAllocationFailure(self->queries);
+	GxAssertAllocationFailure(self->strides);
+	GxAssertAllocationFailure(self->filters);
+	self->stats.allocations += 4;
+	for (Uint32 i = self->bcapacity; i < capacity; i++) {
+		self->candidates[i] = (GxElemBuffer) { NULL, 0, 0 };
+	}
+	self->bcapacity = capacity;
+}
+
+static inline GxBroadphaseFilter physicsFilter(GxPhysics* self, GxElement* elem) {
+	//what a mover collides with: the cmask it shares and the layers its own layer collides with
+	Uint32 cmask = elem == self->forced ? kForceMask : GxElemGetCmask(elem);
+	return (GxBroadphaseFilter) { cmask, GxSceneGetLayerMask_(self->scene, GxElemGetLayer_(elem)) };
+}
+
+static inline bool filterEquals(GxBroadphaseFilter lhs, GxBroadphaseFilter rhs) {
+	return lhs.cmask == rhs.cmask && lhs.layers == rhs.layers;
+}
+
+static inline void physicsPredictTrajectories(GxPhysics* self) {
+	int tickRate = GxSceneGetTickRate(self->scene);
+	self->gacc = physicsGravityStep(self);
+	int step = 0;
+	for (Uint32 i = 0; i < self->bodies.size; i++) {
+		GxElement* body = self->bodies.elems[i];
+		self->strides[i] = SDL_HasIntersection(GxElemGetPosition(body), &self->area) ? 1 : self->farRate;
+		self->filters[i] = physicsFilter(self, body);
+		GxVector move = GxElemPeekStep_(body, self->gacc * self->strides[i], self->strides[i], tickRate);
+		SDL_Rect pos = *GxElemGetPosition(body);
+		SDL_Rect next = { pos.x + move.x, pos.y + move.y, pos.w, pos.h };
+		SDL_UnionRect(&pos, &next, &self->queries[i]);
+		int length = abs(move.x) > abs(move.y) ? abs(move.x) : abs(move.y);
+		if (step < length) step = length;
+	}
+
+	//room for a body's own step plus a push or a carry of the same length
+	self->margin = 2 * step;
+	for (Uint32 i = 0; i < self->bodies.size; i++) {
+		self->queries[i] = inflateRect(self->queries[i], 2 * self->margin + 1);
+	}
+}
+
+static inline void physicsRunQueries(GxPhysics* self) {
+	Uint32 count = self->bodies.size;
+	for (;;) {
+		Uint32 begin = (Uint32) SDL_AtomicAdd(&self->wnext, kBroadphaseChunk);
+		if (begin >= count) break;
+		Uint32 end = begin + kBroadphaseChunk < count ? begin + kBroadphaseChunk : count;
+		for (Uint32 i = begin; i < end; i++) {
+			GxElemBuffer* out = &self->candidates[i];
+			out->size = 0;
+			GxBroadphaseCollectFiltered_(self->fixed, self->queries[i], self->filters[i], out);
+			GxElemBufferSortUnique_(out);
+		}
+	}
+}
+
+static int physicsBroadphaseWorker(void* data) {
+	GxPhysics* self = data;
+	for (;;) {
+		SDL_SemWait(self->wstart);
+		if (SDL_AtomicGet(&self->wquit)) break;
+		physicsRunQueries(self);
+		SDL_SemPost(self->wdone);
+	}
+	return 0;
+}
+
+static inline void physicsStartWorkers(GxPhysics* self) {
+	int count = SDL_GetCPUCount() - 1;
+	if (count > kMaxWorkers) count = kMaxWorkers;
+	if (count <= 0) return;
+	self->wstart = SDL_CreateSemaphore(0);
+	self->wdone = SDL_CreateSemaphore(0);
+	self->workers = malloc(count * sizeof(SDL_Thread*));
+	GxAssertAllocationFailure(self->workers);
+	self->stats.allocations++;
+	for (int i = 0; i < count; i++) {
+		self->workers[i] = SDL_CreateThread(physicsBroadphaseWorker, "broadphaseThread", self);
+		GxAssertAllocationFailure(self->workers[i]);
+	}
+	self->nworkers = count;
+}
+
+static inline void physicsComputeCandidates(GxPhysics* self) {
+	self->stats.queries += self->bodies.size;
+	SDL_AtomicSet(&self->wnext, 0);
+	if (self->bodies.size < kParallelMin) {
+		physicsRunQueries(self);
+		return;
+	}
+
+	//the trees are not modified until every worker is done, so the queries only read them
+	if (!self->workers) physicsStartWorkers(self);
+	for (int i = 0; i < self->nworkers; i++) SDL_SemPost(self->wstart);
+	physicsRunQueries(self);
+	for (int i = 0; i < self->nworkers; i++) SDL_SemWait(self->wdone);
+}
+
+static inline GxElemBuffer* physicsDepthBuffer(GxPhysics* self, GxElemBuffer** buffers, Uint32* capacity, int depth) {
+	if ((Uint32) depth > *capacity) {
+		Uint32 size = *capacity ? *capacity * 2 : 8;
+		while (size < (Uint32) depth) size *= 2;
+		*buffers = realloc(*buffers, size * sizeof(GxElemBuffer));
+		GxAssertAllocationFailure(*buffers);
+		self->stats.allocations++;
+		for (Uint32 i = *capacity; i < size; i++) {
+			(*buffers)[i] = (GxElemBuffer) { NULL, 0, 0 };
+		}
+		*capacity = size;
+	}
+	return &(*buffers)[depth - 1];
+}
+
+static inline GxElemBuffer* physicsQueryCandidates(GxPhysics* self, GxElement* element, SDL_Rect trajectory) {
+	
+	GxBroadphaseFilter filter = physicsFilter(self, element);
+	if (self->resolving && !self->stale && self->depth == 1 && 
+		self->bodies.elems[self->current] == element && filterEquals(filter, self->filters[self->current])) 
+	{
+		SDL_Rect needed = inflateRect(trajectory, self->margin + 1);
+		if (rectContains(&self->queries[self->current], &needed)) {
+			return &self->candidates[self->current];
+		}
+	}
+
+	//live query, kept in id order so both paths resolve contacts identically
+	GxElemBuffer* out = physicsDepthBuffer(self, &self->lqueries, &self->lqcapacity, self->depth);
+	out->size = 0;
+	self->stats.queries++;
+	GxBroadphaseCollectFiltered_(self->fixed, inflateRect(trajectory, 1), filter, out);
+	GxElemBufferSortUnique_(out);
+	return out;
+}
+
+static inline void physicsDropBody(GxPhysics* self, GxElement* element) {
+	//bodies still to be resolved are skipped once removed
+	for (Uint32 i = self->current; i < self->bodies.size; i++) {
+		if (self->bodies.elems[i] == element) {
+			self->bodies.elems[i] = NULL;
+			return;
+		}
+	}
+}
+
+static inline void physicsSelectFarBodies(GxPhysics* self) {
+	//bodies outside the area take turns, so each one runs every farRate ticks
+	Uint32 tick = GxSceneGetTick_(self->scene);
+	Uint32 size = 0;
+	for (Uint32 i = 0; i < self->bodies.size; i++) {
+		GxElement* body = self->bodies.elems[i];
+		if (!SDL_HasIntersection(GxElemGetPosition(body), &self->area) &&
+			(tick + GxElemGetId(body)) % self->farRate) continue;
+		self->bodies.elems[size++] = body;
+	}
+	self->bodies.size = size;
+}
+
+static inline void physicsDropSleepingBodies(GxPhysics* self) {
+	//sleepers stay asleep while they are still supported
+	bool gravity = GxSceneHasGravity(self->scene);
+	Uint32 size = 0;
+	for (Uint32 i = 0; i < self->bodies.size; i++) {
+		GxElement* body = self->bodies.elems[i];
+		if (GxElemIsSleeping(body)) {
+			if (!gravity || GxElemIsOnGround(body)) continue;
+			GxElemWake(body);
+		}
+		self->bodies.elems[size++] = body;
+	}
+	self->bodies.size = size;
+}
+
+//... SENSORS
+//Sensors never take part in the moves. After each pass the bodies that moved are looked up in
+//the sensor tree and the sensors that changed in the dynamic tree, then the sorted pair list is
+//diffed against the previous one to find what entered and exited. Pairs hold ids, so removed
+//elements just drop out without events.
+static inline void idsPush(GxPhysics* self, IdBuffer* buffer, Uint32 id) {
+	//a body moving several times in a row is recorded once
+	if (buffer->size && buffer->ids[buffer->size - 1] == id) return;
+	if (buffer->size == buffer->capacity) {
+		buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 64;
+		buffer->ids = realloc(buffer->ids, buffer->capacity * sizeof(Uint32));
+		GxAssertAllocationFailure(buffer->ids);
+		self->stats.allocations++;
+	}
+	buffer->ids[buffer->size++] = id;
+}
+
+static int idCompare(const void* lhs, const void* rhs) {
+	Uint32 l = *(const Uint32*) lhs, r = *(const Uint32*) rhs;
+	return (l > r) - (l < r);
+}
+
+static inline void idsSortUnique(IdBuffer* buffer) {
+	if (!buffer->size) return;
+	qsort(buffer->ids, buffer->size, sizeof(Uint32), idCompare);
+	Uint32 size = 1;
+	for (Uint32 i = 1; i < buffer->size; i++) {
+		if (buffer->ids[i] != buffer->ids[size - 1]) buffer->ids[size++] = buffer->ids[i];
+	}
+	buffer->size = size;
+}
+
+static inline bool idsContain(const IdBuffer* buffer, Uint32 id) {
+	return buffer->size && bsearch(&id, buffer->ids, buffer->size, sizeof(Uint32), idCompare);
+}
+
+static int sensorPairCompare(const void* lhs, const void* rhs) {
+	const SensorPair* l = lhs;
+	const SensorPair* r = rhs;
+	if (l->sensor != r->sensor) return (l->sensor > r->sensor) - (l->sensor < r->sensor);
+	return (l->body > r->body) - (l->body < r->body);
+}
+
+static inline bool sensorAccepts(GxPhysics* self, GxElement* sensor, GxElement* body) {
+	//seen from the body, as if the sensor were something it could collide with
+	GxBroadphaseFilter filter = physicsFilter(self, body);
+	return (GxElemGetCmask(sensor) & filter.cmask) && (filter.layers & (1u << GxElemGetLayer_(sensor))) &&
+		SDL_HasIntersection(GxElemGetPosition(sensor), GxElemGetPosition(body));
+}
+
+static inline SensorPair* sensorPairsPush(GxPhysics* self, SensorPair* pairs, Uint32* size, 
+	Uint32* capacity, SensorPair pair) 
+{
+	if (*size == *capacity) {
+		Uint32 grown = *capacity ? *capacity * 2 : 64;
+		pairs = physicsArenaGrow(self, pairs, *capacity * sizeof(SensorPair), grown * sizeof(SensorPair));
+		*capacity = grown;
+	}
+	pairs[(*size)++] = pair;
+	return pairs;
+}
+
+static inline void physicsDropSensorPair(GxPhysics* self, SensorPair pair) {
+	SensorPair* found = bsearch(&pair, self->spairs, self->nspairs, sizeof(SensorPair), sensorPairCompare);
+	if (!found) return;
+	self->nspairs--;
+	memmove(found, found + 1, (self->spairs + self->nspairs - found) * sizeof(SensorPair));
+}
+
+static void physicsUpdateSensors(GxPhysics* self) {
+
+	if (!self->smoved.size && !self->sdirty.size) return;
+	ArenaMark mark = physicsArenaMark(self);
+	idsSortUnique(&self->smoved);
+	idsSortUnique(&self->sdirty);
+
+	//keep the pairs nothing changed for, the ones of removed elements end with an exit
+	SensorPair* next = NULL;
+	Uint32 nnext = 0, cnext = 0;
+	for (Uint32 i = 0; i < self->nspairs; i++) {
+		SensorPair pair = self->spairs[i];
+		if (idsContain(&self->smoved, pair.body) || idsContain(&self->sdirty, pair.sensor)) continue;
+		if (!GxSceneGetElement(self->scene, pair.sensor) || !GxSceneGetElement(self->scene, pair.body)) continue;
+		next = sensorPairsPush(self, next, &nnext, &cnext, pair);
+	}
+
+	//then find the pairs of the bodies and sensors that changed
+	for (Uint32 i = 0; i < self->smoved.size; i++) {
+		GxElement* body = GxSceneGetElement(self->scene, self->smoved.ids[i]);
+		if (!body || !GxElemHasDynamicBody(body)) continue;
+		self->sfound.size = 0;
+		self->stats.queries++;
+		GxBroadphaseCollectFiltered_(self->sensors, *GxElemGetPosition(body), physicsFilter(self, body), &self->sfound);
+		GxElemBufferSortUnique_(&self->sfound);
+		for (Uint32 j = 0; j < self->sfound.size; j++) {
+			GxElement* sensor = self->sfound.elems[j];
+			if (!sensorAccepts(self, sensor, body)) continue;
+			next = sensorPairsPush(self, next, &nnext, &cnext, (SensorPair) { GxElemGetId(sensor), GxElemGetId(body) });
+		}
+	}
+	for (Uint32 i = 0; i < self->sdirty.size; i++) {
+		GxElement* sensor = GxSceneGetElement(self->scene, self->sdirty.ids[i]);
+		if (!sensor || !GxElemIsSensor(sensor)) continue;
+		self->sfound.size = 0;
+		self->stats.queries++;
+		GxBroadphaseCollect_(self->dynamic, *GxElemGetPosition(sensor), &self->sfound);
+		GxElemBufferSortUnique_(&self->sfound);
+		for (Uint32 j = 0; j < self->sfound.size; j++) {
+			GxElement* body = self->sfound.elems[j];
+			if (!sensorAccepts(self, sensor, body)) continue;
+			next = sensorPairsPush(self, next, &nnext, &cnext, (SensorPair) { GxElemGetId(sensor), GxElemGetId(body) });
+		}
+	}
+	if (nnext) qsort(next, nnext, sizeof(SensorPair), sensorPairCompare);
+	Uint32 size = 0;
+	for (Uint32 i = 0; i < nnext; i++) {
+		if (!size || sensorPairCompare(&next[i], &next[size - 1])) next[size++] = next[i];
+	}
+	nnext = size;
+	self->smoved.size = 0;
+	self->sdirty.size = 0;
+
+	//the pairs only in the old list exited, the ones only in the new list entered
+	SensorPair* events = NULL;
+	Uint32 nevents = 0, cevents = 0, nexits = 0;
+	for (Uint32 i = 0, j = 0; i < self->nspairs || j < nnext;) {
+		int order = i == self->nspairs ? 1 : j == nnext ? -1 : sensorPairCompare(&self->spairs[i], &next[j]);
+		if (order < 0) {
+			events = sensorPairsPush(self, events, &nevents, &cevents, self->spairs[i]);
+			nexits++;
+		}
+		if (order <= 0) i++;
+		if (order >= 0) j++;
+	}
+	for (Uint32 i = 0, j = 0; j < nnext;) {
+		int order = i == self->nspairs ? 1 : sensorPairCompare(&self->spairs[i], &next[j]);
+		if (order > 0) events = sensorPairsPush(self, events, &nevents, &cevents, next[j]);
+		if (order <= 0) i++;
+		if (order >= 0) j++;
+	}
+
+	if (nnext > self->cspairs) {
+		self->cspairs = nnext * 2;
+		self->spairs = realloc(self->spairs, self->cspairs * sizeof(SensorPair));
+		GxAssertAllocationFailure(self->spairs);
+		self->stats.allocations++;
+	}
+	if (nnext) memcpy(self->spairs, next, nnext * sizeof(SensorPair));
+	self->nspairs = nnext;
+
+	//handlers run last, whatever they move is seen by the next pass. A pair that lost an
+	//element to an earlier handler never entered, so it must not exit later either
+	for (Uint32 i = 0; i < nevents; i++) {
+		int type = i < nexits ? GxEventSensorExit : GxEventSensorEnter;
+		bool entering = type == GxEventSensorEnter;
+		if (entering && (!GxSceneGetElement(self->scene, events[i].sensor) || 
+			!GxSceneGetElement(self->scene, events[i].body))) 
+		{
+			physicsDropSensorPair(self, events[i]);
+			continue;
+		}
+		GxSceneOnSensor_(self->scene, type, events[i].sensor, events[i].body);
+	}
+	physicsArenaRelease(self, mark);
+}
 
 //... METHODS
 void GxPhysicsUpdate_(GxPhysics* self) {
 	
-	SDL_Rect area = *GxElemGetPosition(GxSceneGetCamera(self->scene));
-	area.x -= 64;
-	area.y -= 64;
-	area.w += 128;
-	area.h += 128;
+	Uint64 counter = SDL_GetPerformanceCounter();
+	self->stats.updates++;
+	self->stats.queries++;
+
+	//bodies outside the simulation area are frozen, unless the scene has a far tier
+	self->area = GxSceneGetSimulationArea(self->scene);
+	self->farRate = GxSceneGetFarRate(self->scene);
 	
-	GxQtreeIterate_(self->dynamic, area, physicsMoveElement_, true);
-	GxArrayClean(self->mvstack);
+	//gather the bodies to simulate and compute their candidates
+	self->bodies.size = 0;
+	GxBroadphaseCollect_(self->dynamic, self->farRate ? GxBroadphaseGetPosition_(self->dynamic) : self->area, &self->bodies);
+	GxElemBufferSortUnique_(&self->bodies);
+	if (self->farRate) physicsSelectFarBodies(self);
+	physicsDropSleepingBodies(self);
+	physicsReserveBodies(self, self->bodies.size);
+	physicsPredictTrajectories(self);
+	physicsComputeCandidates(self);
+
+	//then resolve them serially, in id order
+	self->pass++;
+	self->resolving = true;
+	self->batching = GxSceneIsBatchingContacts(self->scene);
+	self->stale = false;
+	bool gravity = GxSceneHasGravity(self->scene);
+	for (self->current = 0; self->current < self->bodies.size; self->current++) {
+		GxElement* body = self->bodies.elems[self->current];
+		self->stride = self->strides[self->current];
+		if (body) physicsMoveElement_(self, body);
+		self->stride = 1;
+		//the body may have been removed by a contact handler
+		if (self->bodies.elems[self->current]) GxElemUpdateRest_(body, gravity);
+	}
+	self->resolving = false;
+	physicsDispatchContactEvents(self);
+	physicsUpdateSensors(self);
+	self->stats.bodies += self->bodies.size;
+	self->stats.counter += SDL_GetPerformanceCounter() - counter;
+}
+
+static inline Uint64 buffersAllocations(const GxElemBuffer* buffers, Uint32 count) {
+	Uint64 allocations = 0;
+	for (Uint32 i = 0; i < count; i++) allocations += buffers[i].allocations;
+	return allocations;
+}
+
+GxPhysicsStats GxPhysicsGetStats_(GxPhysics* self) {
+	GxBroadphaseStats tree = GxBroadphaseGetStats_(self->fixed);
+	self->stats.nodes = tree.nodes;
+	self->stats.depth = tree.depth;
+
+	//the growth of the indexes and query buffers counts along with the module's own
+	GxPhysicsStats stats = self->stats;
+	stats.allocations += tree.allocations;
+	stats.allocations += GxBroadphaseGetStats_(self->dynamic).allocations;
+	stats.allocations += GxBroadphaseGetStats_(self->sensors).allocations;
+	stats.allocations += self->cntend.allocations + self->bodies.allocations;
+	stats.allocations += self->squery.allocations + self->sfound.allocations;
+	stats.allocations += buffersAllocations(self->candidates, self->bcapacity);
+	stats.allocations += buffersAllocations(self->lqueries, self->lqcapacity);
+	stats.allocations += buffersAllocations(self->pqueries, self->pqcapacity);
+	return stats;
+}
+
+void GxPhysicsRebalance_(GxPhysics* self) {
+	GxAssertInvalidOperation(!self->resolving);
+	GxBroadphaseRebalance_(self->fixed);
+	GxBroadphaseRebalance_(self->dynamic);
+	GxBroadphaseRebalance_(self->sensors);
 }
 
 void GxPhysicsInsertElement_(GxPhysics* self, GxElement* element) {
 	if (!GxElemIsPhysical(element)) { return; }
-	GxQtreeInsert_(self->fixed, element);
+	if (GxElemIsSensor(element)) {
+		GxBroadphaseInsert_(self->sensors, element);
+		self->nsensors++;
+		idsPush(self, &self->sdirty, GxElemGetId(element));
+		return;
+	}
+	if (self->nsensors && GxElemHasDynamicBody(element)) idsPush(self, &self->smoved, GxElemGetId(element));
+	self->version++;
+	self->stale = true;
+	GxBroadphaseInsert_(self->fixed, element);
 	if (GxElemHasDynamicBody(element)) {
-		GxQtreeInsert_(self->dynamic, element);
+		GxBroadphaseInsert_(self->dynamic, element);
 	}
 }
 
 void GxPhysicsRemoveElement_(GxPhysics* self, GxElement* element) {
 	if (!GxElemIsPhysical(element)) return;
-	GxQtreeRemove_(self->fixed, element);
+	if (self->nsensors && GxElemIsSensor(element)) {
+		GxBroadphaseRemove_(self->sensors, element);
+		self->nsensors--;
+		idsPush(self, &self->sdirty, GxElemGetId(element));
+		return;
+	}
+	if (self->nsensors && GxElemHasDynamicBody(element)) idsPush(self, &self->smoved, GxElemGetId(element));
+	self->version++;
+	self->stale = true;
+	GxBroadphaseRemove_(self->fixed, element);
 	
 	if (GxElemHasDynamicBody(element)) {
-		GxQtreeRemove_(self->dynamic, element);
+		GxBroadphaseRemove_(self->dynamic, element);
+		if (self->resolving) physicsDropBody(self, element);
 	}
 
-	GxArray* contacts = GxCreateArray();
-	
-	for (Uint32 i = 0; i < GxArraySize(self->contacts); i++){
-		GxContact* contact = GxArrayAt(self->contacts, i);
-		if (contact->colliding == element || contact->collided == element) {			
-			GxArrayPush(contacts, contact, destroyContact);
-		}
+	//destroyContact removes the contact from the element list as well
+	Uint32 count;
+	GxContact* const* contacts = GxElemGetContactArray_(element, &count);
+	while (count && !GxSceneHasStatus(self->scene, GxStatusUnloading)) {
+		destroyContact(contacts[0]);
+		contacts = GxElemGetContactArray_(element, &count);
+	}
+}
+
+void GxPhysicsRefreshElement_(GxPhysics* self, GxElement* element) {
+	//the collision filter changed, so the precomputed candidates no longer hold
+	if (!GxElemIsPhysical(element)) return;
+	if (self->nsensors && GxElemIsSensor(element)) {
+		GxBroadphaseRefresh_(self->sensors, element);
+		idsPush(self, &self->sdirty, GxElemGetId(element));
+		return;
 	}
-	//the contacts are destroyed with the array
-	GxDestroyArray(contacts);
+	if (self->nsensors && GxElemHasDynamicBody(element)) idsPush(self, &self->smoved, GxElemGetId(element));
+	self->stale = true;
+	GxBroadphaseRefresh_(self->fixed, element);
+	if (GxElemHasDynamicBody(element)) GxBroadphaseRefresh_(self->dynamic, element);
+}
+
+void GxPhysicsCheckContacts_(GxPhysics* self, GxElement* element) {
+	//the shape of the element changed in place, so some contacts may no longer touch
+	ArenaMark mark = physicsArenaMark(self);
+	physicsCheckContactEnd(self, element);
+	physicsArenaRelease(self, mark);
 }
 
 void GxPhysicsUpdateElementPosition_(GxPhysics* self, GxElement* element, SDL_Rect previousPos) {	
-	if(GxElemIsPhysical(element)){
+	if (self->nsensors && GxElemIsPhysical(element) && GxElemIsSensor(element)) {
+		GxBroadphaseUpdate_(self->sensors, element, previousPos);
+		idsPush(self, &self->sdirty, GxElemGetId(element));
+	}
+	else if(GxElemIsPhysical(element)){
+		if (self->nsensors && GxElemHasDynamicBody(element)) idsPush(self, &self->smoved, GxElemGetId(element));
+		if (self->resolving && !self->stale) {
+			const SDL_Rect* pos = GxElemGetPosition(element);
+			int dx = abs(pos->x - previousPos.x), dy = abs(pos->y - previousPos.y);
+			if (GxElemAddTravel_(element, self->pass, dx > dy ? dx : dy) > self->margin) {
+				self->stale = true;
+			}
+		}
 		if (GxElemHasDynamicBody(element)) {
-			GxQtreeUpdate_(self->dynamic, element, previousPos);
+			GxBroadphaseUpdate_(self->dynamic, element, previousPos);
 		}	
-		GxQtreeUpdate_(self->fixed, element, previousPos);
+		GxBroadphaseUpdate_(self->fixed, element, previousPos);
 	}	
 }
 
-GxVector GxPhysicsMoveCalledByElem_(GxPhysics* self, GxElement* element) {
-	physicsMoveElement_(element);
-	return *(GxVector*) GxArrayLast(self->mvstack); 
+GxVector GxPhysicsMoveCalledByElem_(GxPhysics* self, GxElement* element, bool force) {
+	//the force filter only lives for this move, the cached cmask of the trees stays valid
+	GxElement* forced = self->forced;
+	if (force) self->forced = element;
+	GxVector move = physicsMoveElement_(self, element);
+	self->forced = forced;
+	return move;
 }
 
-static inline void physicsMoveElement_(GxElement* element) {
+static inline GxVector physicsMoveElement_(GxPhysics* physics, GxElement* element) {
 
 	GxAssertInvalidOperation(!GxElemGetMcFlag_(element));
-	GxPhysics* physics = GxSceneGetPhysics(GxElemGetScene(element));			
-	physicsApplyGravity(physics, element);
-	bool cantmove = GxElemGetMovFlag_(element) || !GxElemIsMoving(element);		
+	
+	//only the pass's own move of a far body covers several ticks
+	int stride = physics->stride;
+	physics->stride = 1;
+	physicsApplyGravity(physics, element, stride);
+	GxVector move = { 0, 0 };
+	if (!GxElemGetMovFlag_(element)) move = GxElemTakeStep_(element, stride, GxSceneGetTickRate(physics->scene));
+	bool cantmove = !move.x && !move.y;
 	if (cantmove) {
-		GxVector* vector = malloc(sizeof(GxVector));
-		GxAssertAllocationFailure(vector);
-		*vector = (GxVector){ 0, 0 };
-		GxArrayPush(physics->mvstack, vector, free);		
-		return;
+		return move;
 	}	
 	GxElemSetMovFlag_(element, true);	
 	physics->depth++;
-	GxArrayPush(physics->cntend, element, NULL);
-				
-	EmData* emdata = createEmData(element);
-	GxArrayPush(physics->emdstack, emdata, (GxDestructor) destroyEmData);
-	GxQtreeIterate_(physics->fixed, emdata->trajetory, physicsCheckCollision, true);
-	GxVector* vec = malloc(sizeof(GxVector));
-	GxAssertAllocationFailure(vec);
+	GxElemBufferPush_(&physics->cntend, element);
 	
-	*vec = physicsProcessMovementData(physics);
-	GxArrayPush(physics->mvstack, vec, free);
+	ArenaMark mark = physicsArenaMark(physics);
+	EmData* emdata = createEmData(physics, element, move);
+	emdata->candidates = physicsQueryCandidates(physics, element, emdata->trajetory);
+	for (Uint32 i = 0; i < emdata->candidates->size; i++) {
+		physicsCheckCollision(physics, emdata->candidates->elems[i]);
+	}
+	move = physicsProcessMovementData(physics);
 
 	if (GxSceneHasGravity(physics->scene) && GxElemGetMaxgvel(element)) {		
-		GxQtreeIterate_(physics->fixed, emdata->trajetory, physicsCheckGround, true);
+		//elements may have been pushed meanwhile, so the candidates are validated again
+		//and the loop stops if a contact handler inserts or removes an element
+		GxElemBuffer* candidates = physicsQueryCandidates(physics, element, emdata->trajetory);
+		Uint32 version = physics->version;
+		for (Uint32 i = 0; i < candidates->size && physics->version == version; i++) {
+			physicsCheckGround(physics, candidates->elems[i]);
+		}
 	}
 	
-	GxArrayRemove(physics->emdstack, GxArraySize(physics->emdstack) - 1);
+	physics->emdata = emdata->prev;
 	GxElemSetMovFlag_(element, false);	
 	physics->depth--;
 	if (physics->depth == 0) {
-		for (Uint32 i = 0; i < GxArraySize(physics->cntend); i++){
-			GxElement* elem = GxArrayAt(physics->cntend, i);
+		for (Uint32 i = 0; i < physics->cntend.size; i++){
+			GxElement* elem = physics->cntend.elems[i];
 			physicsCheckContactEnd(physics, elem);			
 		}
-		GxArrayClean(physics->cntend);
+		physics->cntend.size = 0;
 	}
+	physicsArenaRelease(physics, mark);
+	return move;
 }
 
-static inline void physicsApplyGravity(GxPhysics* self, GxElement* elem) {	
+static inline void physicsApplyGravity(GxPhysics* self, GxElement* elem, int stride) {	
 
-	int maxgvel = GxElemGetMaxgvel(elem);
-	int gravity = GxSceneGetGravity(self->scene);
-	int vely = GxElemGetVely(elem);
-	if (gravity && (maxgvel < vely) && !GxElemIsOnGround(elem)) {
-		double acceleration = gravity / 60.0;
-		GxElemAccelerate(elem, 0, acceleration);
+	Sint32 acceleration = physicsGravityStep(self);
+	if (acceleration) {
+		GxElemApplyGravity_(elem, acceleration * stride);
 	}	
 }
 
+static inline Sint32 physicsGravityStep(GxPhysics* self) {
+	//gravity is the velocity gained per second, each tick adds its share of it
+	int gravity = GxSceneGetGravity(self->scene);
+	return gravity ? gravity * GxFixedOne_ / GxSceneGetTickRate(self->scene) : 0;
+}
+
+//... CARRIERS
+//A moving body with friction carries what stands on it. The riders of the whole stack are
+//gathered breadth first into a carrier graph once the body has moved, each keeping the first
+//carrier that reached it, and then moved in that order by what their carrier actually moved.
+//So every rider makes a single move and deep stacks cost linear time.
+typedef struct Rider {
+	Uint32 id;
+	Uint32 carrier; //index of the carrier in the graph
+	GxVector move; //displacement the rider made
+} Rider;
+
 static inline void physicsApplyFriction(GxPhysics* self, GxElement* element, GxVector move) {	
-	if (GxSceneHasGravity(self->scene) && GxElemHasFriction(element)) {
-		move = (GxVector) { move.x, move.y < 0 ? move.y : 0 };
-		GxArray* up = GxElemGetContacts(element, GxContactUp);
-		for (Uint32 i = 0; i < GxArraySize(up); i++){
-		GxContact* contact = GxArrayAt(up, i); 
-			GxElement* other = contact->colliding == element ? contact->collided : contact->colliding;
-			GxElemMove(other, move, false);
+	if (!GxSceneHasGravity(self->scene) || !GxElemHasFriction(element)) return;
+	//the graph moving this rider has already gathered what stands on it
+	if (element == self->carried) return;
+
+	//moving the riders changes the contact lists, so the graph is built first
+	Uint32 stamp = ++self->carry, count = 1, capacity = 8;
+	Rider* riders = physicsArenaAlloc(self, capacity * sizeof(Rider));
+	riders[0] = (Rider) { GxElemGetId(element), 0, move };
+	GxElemSetCarryFlag_(element, stamp);
+	for (Uint32 i = 0; i < count; i++) {
+		GxElement* carrier = i ? GxSceneGetElement(self->scene, riders[i].id) : element;
+		if (i && !GxElemHasFriction(carrier)) continue;
+		Uint32 cursor = 0;
+		for (GxContact* contact = GxElemNextContact(carrier, GxContactUp, &cursor); contact != NULL;
+			contact = GxElemNextContact(carrier, GxContactUp, &cursor))
+		{
+			GxElement* rider = contact->colliding == carrier ? contact->collided : contact->colliding;
+			if (GxElemGetCarryFlag_(rider) == stamp) continue;
+			GxElemSetCarryFlag_(rider, stamp);
+			if (count == capacity) {
+				riders = physicsArenaGrow(self, riders, capacity * sizeof(Rider), capacity * 2 * sizeof(Rider));
+				capacity *= 2;
+			}
+			riders[count++] = (Rider) { GxElemGetId(rider), i, { 0, 0 } };
 		}
 	}
+
+	//then move them, a handler may have removed any of them meanwhile
+	GxElement* carried = self->carried;
+	for (Uint32 i = 1; i < count; i++) {
+		GxElement* rider = GxSceneGetElement(self->scene, riders[i].id);
+		GxVector carry = riders[riders[i].carrier].move;
+		carry.y = carry.y < 0 ? carry.y : 0;
+		if (!rider || (!carry.x && !carry.y)) continue;
+		self->carried = rider;
+		riders[i].move = GxElemMove(rider, carry, false);
+	}
+	self->carried = carried;
+}
+
+//... SWEPT AABB
+//Each axis is described by the distances the body travels until it enters and exits the other
+//element, over the distance it travels in the step. Times are compared by cross multiplication,
+//so the test never leaves integer arithmetic.
+typedef struct SweptAxis {
+	bool hit;
+	int entry;
+	int exit;
+	int length;
+} SweptAxis;
+
+static inline SweptAxis sweepAxis(int smin, int smax, int omin, int omax, int velocity) {
+	if (velocity > 0) {
+		return (SweptAxis) { true, omin - smax, omax - smin, velocity };
+	}
+	else if (velocity < 0) {
+		return (SweptAxis) { true, smin - omax, smax - omin, -velocity };
+	}
+
+	//a still axis overlaps during the whole step or never
+	bool overlap = smin < omax && smax > omin;
+	return (SweptAxis) { overlap, INT_MIN / 2, INT_MAX / 2, 1 };
 }
 
-static inline void physicsCheckCollision(GxElement* other) {	
+static inline int sweptCompare(int lhs, int llength, int rhs, int rlength) {
+	int64_t l = (int64_t) lhs * rlength;
+	int64_t r = (int64_t) rhs * llength;
+	return (l > r) - (l < r);
+}
+
+//the axes a body moving by v hits o on and how far it moves until then
+typedef struct SweptHit {
+	bool x, y;
+	int xmove, ymove;
+} SweptHit;
+
+static inline SweptHit sweepRect(const SDL_Rect* s, const SDL_Rect* o, GxVector v) {
+	SweptHit hit = { false, false, 0, 0 };
+	SweptAxis x = sweepAxis(s->x, s->x + s->w, o->x, o->x + o->w, v.x);
+	SweptAxis y = sweepAxis(s->y, s->y + s->h, o->y, o->y + o->h, v.y);
+	if (!x.hit || !y.hit) return hit;
+
+	//the axes only overlap together between the latest entry and the earliest exit
+	int xentry = sweptCompare(x.entry, x.length, y.entry, y.length);
+	SweptAxis* first = xentry >= 0 ? &x : &y;
+	SweptAxis* last = xentry >= 0 ? &y : &x;
+	if (sweptCompare(first->entry, first->length, last->exit, last->length) >= 0) return hit;
+	if (first->entry < 0 || first->entry >= first->length) return hit;
+
+	//on a tie the body hits the corner, so both directions make contact
+	if (xentry >= 0) {
+		hit.x = true;
+		hit.xmove = v.x > 0 ? x.entry : -x.entry;
+	}
+	if (xentry <= 0) {
+		hit.y = true;
+		hit.ymove = v.y > 0 ? y.entry : -y.entry;
+	}
+	return hit;
+}
+
+//... TILE GRIDS
+//A tilemap in grid mode is one fixed element whose solid part is a set of cells, with row 0 on
+//top. Whatever reads its shape first clips the area of interest to the cells it covers, so the
+//cost depends on the tiles crossed and not on the size of the map.
+typedef struct GridSpan {
+	const Uint8* tiles;
+	GxMatrix matrix;
+	SDL_Rect pos;
+	int tw, th;
+	int r0, r1, c0, c1; //inclusive
+} GridSpan;
+
+static inline bool isGrid(GxElement* elem) {
+	return GxElemGetTileGrid_(elem, NULL) != NULL;
+}
+
+static inline bool gridSpan(GxElement* grid, const SDL_Rect* area, GridSpan* span) {
+	span->tiles = GxElemGetTileGrid_(grid, &span->matrix);
+	span->pos = *GxElemGetPosition(grid);
+	span->tw = span->pos.w / span->matrix.nc;
+	span->th = span->pos.h / span->matrix.nr;
+	SDL_Rect clip;
+	if (!span->tw || !span->th || !SDL_IntersectRect(&span->pos, area, &clip)) return false;
+	
+	int top = span->pos.y + span->pos.h;
+	span->c0 = (clip.x - span->pos.x) / span->tw;
+	span->c1 = (clip.x + clip.w - 1 - span->pos.x) / span->tw;
+	span->r0 = (top - (clip.y + clip.h)) / span->th;
+	span->r1 = (top - clip.y - 1) / span->th;
+	if (span->c1 >= span->matrix.nc) span->c1 = span->matrix.nc - 1;
+	if (span->r1 >= span->matrix.nr) span->r1 = span->matrix.nr - 1;
+	return span->c0 <= span->c1 && span->r0 <= span->r1;
+}
+
+static inline bool gridSolid(const GridSpan* span, int row, int col) {
+	return row >= 0 && row < span->matrix.nr && col >= 0 && col < span->matrix.nc &&
+		span->tiles[row * span->matrix.nc + col];
+}
+
+static inline SDL_Rect gridCell(const GridSpan* span, int row, int col) {
+	return (SDL_Rect) { 
+		span->pos.x + col * span->tw, 
+		span->pos.y + span->pos.h - (row + 1) * span->th, 
+		span->tw, 
+		span->th 
+	};
+}
+
+static inline SweptHit sweepGrid(GxElement* grid, const SDL_Rect* s, GxVector v, const SDL_Rect* trajectory) {
+	SweptHit best = { false, false, 0, 0 };
+	GridSpan span;
+	if (!gridSpan(grid, trajectory, &span)) return best;
+
+	for (int row = span.r0; row <= span.r1; row++) {
+		for (int col = span.c0; col <= span.c1; col++) {
+			if (!gridSolid(&span, row, col)) continue;
+			SDL_Rect cell = gridCell(&span, row, col);
+			SweptHit hit = sweepRect(s, &cell, v);
+
+			//a face shared with another solid cell can't be reached, so sliding over seams never snags
+			if (hit.x && gridSolid(&span, row, v.x > 0 ? col - 1 : col + 1)) hit.x = false;
+			if (hit.y && gridSolid(&span, v.y > 0 ? row + 1 : row - 1, col)) hit.y = false;
+
+			if (hit.x && (!best.x || abs(hit.xmove) < abs(best.xmove))) {
+				best.x = true;
+				best.xmove = hit.xmove;
+			}
+			if (hit.y && (!best.y || abs(hit.ymove) < abs(best.ymove))) {
+				best.y = true;
+				best.ymove = hit.ymove;
+			}
+		}
+	}
+	return best;
+}
+
+//whether a solid part of elem overlaps area
+static inline bool physicsOverlaps(GxElement* elem, const SDL_Rect* area) {
+	if (!isGrid(elem)) return SDL_HasIntersection(GxElemGetPosition(elem), area);
+
+	GridSpan span;
+	if (!gridSpan(elem, area, &span)) return false;
+	for (int row = span.r0; row <= span.r1; row++) {
+		for (int col = span.c0; col <= span.c1; col++) {
+			SDL_Rect cell = gridCell(&span, row, col);
+			if (gridSolid(&span, row, col) && SDL_HasIntersection(&cell, area)) return true;
+		}
+	}
+	return false;
+}
+
+//the one pixel strip just outside the side of s that faces direction
+static inline SDL_Rect sideStrip(const SDL_Rect* s, Uint32 direction) {
+	switch (direction) {
+		case GxContactRight: return (SDL_Rect) { s->x + s->w, s->y, 1, s->h };
+		case GxContactLeft: return (SDL_Rect) { s->x - 1, s->y, 1, s->h };
+		case GxContactUp: return (SDL_Rect) { s->x, s->y + s->h, s->w, 1 };
+		default: return (SDL_Rect) { s->x, s->y - 1, s->w, 1 };
+	}
+}
+
+static inline void physicsCheckCollision(GxPhysics* physics, GxElement* other) {	
 	
 	//create alias	
-	GxPhysics* physics = GxSceneGetPhysics(GxElemGetScene(other));
-	EmData* emdata = GxArrayLast(physics->emdstack);
+	EmData* emdata = physics->emdata;
 	GxElement* self = emdata->self;	
 
+	//the candidates already passed the collision filter
 	if (self == other) return;
-	if (!(GxElemGetCmask(self) & GxElemGetCmask(other))) return;
 
 	//create alias
-	GxVector v = GxElemGetVelocity(self);
+	GxVector v = emdata->move;
 	const SDL_Rect* s = GxElemGetPosition(self);
 	const SDL_Rect* o = GxElemGetPosition(other);	
 	
-	if (SDL_HasIntersection(&emdata->trajetory, o)) {
+	if (!SDL_HasIntersection(&emdata->trajetory, o)) return;
+
+	SweptHit hit = isGrid(other) ? sweepGrid(other, s, v, &emdata->trajetory) : sweepRect(s, o, v);
+	if (hit.x) {
+		Uint32 direction = v.x > 0 ? GxContactRight : GxContactLeft;
+		emdataPushContact(physics, emdata, createContact(physics, self, other, hit.xmove, direction));
+	}
+	if (hit.y) {
+		Uint32 direction = v.y > 0 ? GxContactUp : GxContactDown;
+		emdataPushContact(physics, emdata, createContact(physics, self, other, hit.ymove, direction));
+	}
+}
+
+//... PUSH SOLVER
+//Pushes are solved along one axis without recursion. Coordinates are mirrored so the push always
+//goes towards +lo. The slack of an element is how far the root travels before the element starts
+//moving; pushable elements extend the chain and every other reached element limits it.
+typedef struct PushNode {
+	GxElement* elem;
+	int lo, hi;   //extent along the push
+	int plo, phi; //extent across it
+	int slack;
+	bool pushable;
+	Uint32 cmask;
+	Uint32 layer;  //layer bit
+	Uint32 layers; //layers it collides with
+	bool cell;     //a solid cell of a tile grid, which never moves
+	SDL_Rect tile;
+} PushNode;
+
+typedef struct PushPair {
+	Uint32 pusher;
+	Uint32 pushed;
+	GxContact* contact;
+} PushPair;
+
+static inline void pushExtent(const SDL_Rect* r, Uint32 direction, PushNode* node) {
+	if (direction == GxContactRight || direction == GxContactLeft) {
+		node->lo = direction == GxContactRight ? r->x : -(r->x + r->w);
+		node->plo = r->y;
+		node->phi = r->y + r->h;
+		node->hi = node->lo + r->w;
+	}
+	else {
+		node->lo = direction == GxContactUp ? r->y : -(r->y + r->h);
+		node->plo = r->x;
+		node->phi = r->x + r->w;
+		node->hi = node->lo + r->h;
+	}
+}
+
+static inline GxVector pushVector(Uint32 direction, int distance) {
+	switch (direction) {
+		case GxContactRight: return (GxVector) { distance, 0 };
+		case GxContactLeft: return (GxVector) { -distance, 0 };
+		case GxContactUp: return (GxVector) { 0, distance };
+		default: return (GxVector) { 0, -distance };
+	}
+}
+
+static inline SDL_Rect pushReach(SDL_Rect r, Uint32 direction, int distance) {
+	SDL_Rect moved = r;
+	GxVector v = pushVector(direction, distance);
+	moved.x += v.x;
+	moved.y += v.y;
+	SDL_UnionRect(&r, &moved, &r);
+	return r;
+}
+
+static inline const SDL_Rect* pushNodeRect(const PushNode* node) {
+	return node->cell ? &node->tile : GxElemGetPosition(node->elem);
+}
+
+static int pushNodeCompare(const void* lhs, const void* rhs) {
+	const PushNode* l = lhs;
+	const PushNode* r = rhs;
+	if (l->lo != r->lo) return (l->lo > r->lo) - (l->lo < r->lo);
+	Uint32 lid = GxElemGetId(l->elem), rid = GxElemGetId(r->elem);
+	if (lid != rid) return (lid > rid) - (lid < rid);
+
+	//the cells of a grid share its id, qsort is not stable so their tiles break the tie
+	if (l->tile.y != r->tile.y) return (l->tile.y > r->tile.y) - (l->tile.y < r->tile.y);
+	return (l->tile.x > r->tile.x) - (l->tile.x < r->tile.x);
+}
+
+static inline bool pushCanReach(const PushNode* pusher, const PushNode* pushed, int distance) {
+	return pusher->slack < distance && pusher->pushable &&
+		pushed->lo >= pusher->hi && pusher->slack + (pushed->lo - pusher->hi) < distance &&
+		pushed->plo < pusher->phi && pushed->phi > pusher->plo &&
+		(pusher->cmask & pushed->cmask) && (pusher->layers & pushed->layer);
+}
+
+//collects the elements around root, with root first and the others ordered along the push
+static inline Uint32 physicsPushNodes(GxPhysics* self, GxElement* root, Uint32 direction, 
+	int preference, SDL_Rect area, PushNode** nodes, Uint32* capacity) 
+{
+	GxElemBuffer* found = physicsDepthBuffer(self, &self->pqueries, &self->pqcapacity, self->depth);
+	found->size = 0;
+	self->stats.queries++;
+	GxBroadphaseCollect_(self->fixed, area, found);
+	GxElemBufferSortUnique_(found);
+
+	//a tile grid takes one node per solid cell inside the area
+	Uint32 needed = 1;
+	for (Uint32 i = 0; i < found->size; i++) {
+		GridSpan span;
+		if (!isGrid(found->elems[i])) needed++;
+		else if (gridSpan(found->elems[i], &area, &span)) {
+			needed += (Uint32) ((span.r1 - span.r0 + 1) * (span.c1 - span.c0 + 1));
+		}
+	}
+	if (needed > *capacity) {
+		*capacity = needed;
+		*nodes = physicsArenaAlloc(self, *capacity * sizeof(PushNode));
+	}
 
-		if (!emdata->contacts) emdata->contacts = GxCreateArray();
+	Uint32 count = 0;
+	(*nodes)[count++] = (PushNode) { .elem = root, .slack = 0, .pushable = true };
+	for (Uint32 i = 0; i < found->size; i++) {
+		GxElement* elem = found->elems[i];
+		if (elem == root) continue;
+		GridSpan span;
+		if (isGrid(elem)) {
+			if (!gridSpan(elem, &area, &span)) continue;
+			for (int row = span.r0; row <= span.r1; row++) {
+				for (int col = span.c0; col <= span.c1; col++) {
+					if (!gridSolid(&span, row, col)) continue;
+					(*nodes)[count++] = (PushNode) { 
+						.elem = elem, 
+						.slack = INT_MAX, 
+						.cell = true, 
+						.tile = gridCell(&span, row, col),
+					};
+				}
+			}
+			continue;
+		}
+		bool locked = GxElemGetMovFlag_(elem) || GxElemGetMcFlag_(elem);
+		(*nodes)[count++] = (PushNode) { 
+			.elem = elem, 
+			.slack = INT_MAX, 
+			.pushable = !locked && GxElemGetPreference(elem) < preference,
+		};
+	}
+	for (Uint32 i = 0; i < count; i++) {
+		PushNode* node = &(*nodes)[i];
+		pushExtent(pushNodeRect(node), direction, node);
+		GxBroadphaseFilter filter = physicsFilter(self, node->elem);
+		node->cmask = filter.cmask;
+		node->layers = filter.layers;
+		node->layer = 1u << GxElemGetLayer_(node->elem);
+	}
+	qsort(*nodes + 1, count - 1, sizeof(PushNode), pushNodeCompare);
+	return count;
+}
 
-		//check horizontal direction
-		if (v.x > 0) {
-			int amove = o->x - (s->x + s->w);
-			if (amove >= 0 && amove < v.x) {
-				GxArrayPush(emdata->contacts, createContact(self, other, amove, GxContactRight), NULL);
+static int physicsPush(GxPhysics* self, GxElement* root, Uint32 direction, int distance, int preference) {
+
+	if (distance <= 0 || GxElemGetMovFlag_(root) || GxElemGetMcFlag_(root)) return 0;
+
+	PushNode* nodes = NULL;
+	Uint32 capacity = 0, count = 0;
+
+	//first find every element the chain can reach, growing the query until it covers the chain
+	SDL_Rect area = pushReach(*GxElemGetPosition(root), direction, distance);
+	for (;;) {
+		count = physicsPushNodes(self, root, direction, preference, area, &nodes, &capacity);
+		for (Uint32 i = 1; i < count; i++) {
+			for (Uint32 j = 0; j < i; j++) {
+				if (pushCanReach(&nodes[j], &nodes[i], distance)) {
+					int slack = nodes[j].slack + (nodes[i].lo - nodes[j].hi);
+					if (slack < nodes[i].slack) nodes[i].slack = slack;
+				}
 			}
 		}
-		else if (v.x < 0) {
-			int amove = (o->x + o->w) - s->x;
-			if (amove <= 0 && amove > v.x) {
-				GxArrayPush(emdata->contacts, createContact(self, other, amove, GxContactLeft), NULL);
-			}		
+		SDL_Rect needed = area;
+		for (Uint32 i = 0; i < count; i++) {
+			if (nodes[i].pushable && nodes[i].slack < distance) {
+				SDL_Rect reach = pushReach(*GxElemGetPosition(nodes[i].elem), direction, distance - nodes[i].slack);
+				SDL_UnionRect(&needed, &reach, &needed);
+			}
 		}
+		if (rectContains(&area, &needed)) break;
+		SDL_UnionRect(&area, &needed, &area);
+		area = pushReach(area, direction, distance);
+	}
 
-		//check vertical direction
-		if (v.y > 0) {
-			int amove = o->y - (s->y + s->h);
-			if (amove >= 0 && amove < v.y) {
-				GxArrayPush(emdata->contacts, createContact(self, other, amove, GxContactUp), NULL);
+	//then create the contacts, so handlers can prevent them, and compute the allowed displacement
+	PushPair* pairs = NULL;
+	Uint32 npairs = 0, pcapacity = 0;
+	int allowed = distance;
+	for (Uint32 i = 1; i < count; i++) nodes[i].slack = INT_MAX;
+	for (Uint32 i = 1; i < count; i++) {
+		for (Uint32 j = 0; j < i; j++) {
+			if (!pushCanReach(&nodes[j], &nodes[i], distance)) continue;
+			int gap = nodes[i].lo - nodes[j].hi;
+			bool negative = direction == GxContactLeft || direction == GxContactDown;
+			GxContact* contact = createContact(self, nodes[j].elem, nodes[i].elem, negative ? -gap : gap, direction);
+			GxSceneOnPreContact_(self->scene, contact);
+			if (npairs == pcapacity) {
+				Uint32 grown = pcapacity ? pcapacity * 2 : 8;
+				pairs = physicsArenaGrow(self, pairs, pcapacity * sizeof(PushPair), grown * sizeof(PushPair));
+				pcapacity = grown;
 			}
+			pairs[npairs++] = (PushPair) { j, i, contact };
+			if (!contact->prevented && nodes[j].slack + gap < nodes[i].slack) {
+				nodes[i].slack = nodes[j].slack + gap;
+			}
+		}
+		if (!nodes[i].pushable && nodes[i].slack < allowed) allowed = nodes[i].slack;
+	}
+
+	//apply the moves from the farthest element to the root
+	for (Uint32 i = count; i-- > 0;) {
+		if (nodes[i].pushable && nodes[i].slack < allowed) {
+			GxElemExecuteMove_(nodes[i].elem, pushVector(direction, allowed - nodes[i].slack));
+			GxElemBufferPush_(&self->cntend, nodes[i].elem);
+		}
+	}
+
+	//keep the contacts of elements that ended touching
+	Uint32 added = 0;
+	for (Uint32 k = 0; k < npairs; k++) {
+		GxContact* contact = pairs[k].contact;
+		PushNode pusher = nodes[pairs[k].pusher], pushed = nodes[pairs[k].pushed];
+		pushExtent(pushNodeRect(&pusher), direction, &pusher);
+		pushExtent(pushNodeRect(&pushed), direction, &pushed);
+		bool keep = contact->prevented ?
+			SDL_HasIntersection(pushNodeRect(&pusher), pushNodeRect(&pushed)) :
+			pushed.lo == pusher.hi;
+		if (keep && physicsAddContact(self, contact)) pairs[added++].contact = contact;
+		else if (!keep) destroyContact(contact);
+	}
+	for (Uint32 k = 0; k < added; k++) {
+		if (pairs[k].contact->effective) physicsContactEvent(self, GxEventContactBegin, pairs[k].contact);
+	}
+
+	//finally the moved elements carry what stands on them
+	for (Uint32 i = 0; i < count; i++) {
+		if (nodes[i].pushable && nodes[i].slack < allowed) {
+			physicsApplyFriction(self, nodes[i].elem, pushVector(direction, allowed - nodes[i].slack));
 		}
-		else if (v.y < 0) {
-			int amove = (o->y + o->h) - s->y;
-			if (amove <= 0 && amove > v.y) {
-				GxArrayPush(emdata->contacts, createContact(self, other, amove, GxContactDown), NULL);
-			}		
-		}		
 	}
+
+	return allowed;
 }
 
 static inline GxVector physicsProcessMovementData(GxPhysics* self) {	
 
 	//get emdata
-	EmData* emdata = GxArrayLast(self->emdstack);
+	EmData* emdata = self->emdata;
 
-	//gets self velocity
-	GxVector move = GxElemGetVelocity(emdata->self);
+	//gets self displacement in this step
+	GxVector move = emdata->move;
 
 	//if there is no contact, just move the element
-	if (!emdata->contacts) {			
+	if (!emdata->ncontacts) {			
 		GxElemExecuteMove_(emdata->self, move);
 		physicsApplyFriction(self, emdata->self, move);
 		return move;
@@ -324,8 +1635,8 @@ static inline GxVector physicsProcessMovementData(GxPhysics* self) {
 	
 	bool horizontalCollision = false, verticalCollision = false;
 
-	for (Uint32 i = 0; i < GxArraySize(emdata->contacts); i++){
-		GxContact* contact = GxArrayAt(emdata->contacts, i);
+	for (Uint32 i = 0; i < emdata->ncontacts; i++){
+		GxContact* contact = emdata->contacts[i];
 		GxSceneOnPreContact_(self->scene, contact);
 		if (contact->prevented) { continue; }
 
@@ -336,9 +1647,7 @@ static inline GxVector physicsProcessMovementData(GxPhysics* self) {
 		
 		if (contact->direction == GxContactRight && move.x >= contact->amove) {			
 			if (spref > opref) {
-				GxElemSetPreference(contact->collided, spref);
-				GxElemMove(contact->collided, (GxVector) { (spos.x + move.x + spos.w) - opos.x, 0 }, false);				
-				GxElemSetPreference(contact->collided, opref);
+				opos.x += physicsPush(self, contact->collided, GxContactRight, (spos.x + move.x + spos.w) - opos.x, spref);
 				contact->amove = (opos.x - (spos.x + spos.w));
 			}			
 			if(move.x >= contact->amove) {
@@ -348,9 +1657,7 @@ static inline GxVector physicsProcessMovementData(GxPhysics* self) {
 		}
 		else if (contact->direction == GxContactLeft && move.x <= contact->amove) {
 			if (spref > opref) {
-				GxElemSetPreference(contact->collided, spref);
-				GxElemMove(contact->collided, (GxVector) {(spos.x + move.x) - (opos.x + opos.w), 0 }, false);				
-				GxElemSetPreference(contact->collided, opref);
+				opos.x -= physicsPush(self, contact->collided, GxContactLeft, (opos.x + opos.w) - (spos.x + move.x), spref);
 				contact->amove = ((opos.x + opos.w) - spos.x);
 			}			
 			if(move.x <= contact->amove){
@@ -360,9 +1667,7 @@ static inline GxVector physicsProcessMovementData(GxPhysics* self) {
 		}
 		else if (contact->direction == GxContactUp && move.y >= contact->amove) {
 			if (spref > opref) {				
-				GxElemSetPreference(contact->collided, spref);
-				GxElemMove(contact->collided, (GxVector) { 0, (spos.y + move.y + spos.h) - opos.y}, false);				
-				GxElemSetPreference(contact->collided, opref);
+				opos.y += physicsPush(self, contact->collided, GxContactUp, (spos.y + move.y + spos.h) - opos.y, spref);
 				contact->amove = opos.y - (spos.y + spos.h);			
 			}			
 			if(move.y >= contact->amove){
@@ -372,9 +1677,7 @@ static inline GxVector physicsProcessMovementData(GxPhysics* self) {
 		}
 		else if (contact->direction == GxContactDown && move.y <= contact->amove) {
 			if (spref > opref) {	
-				GxElemSetPreference(contact->collided, spref);
-				GxElemMove(contact->collided, (GxVector) {0, (spos.y + move.y) - (opos.y + opos.h)}, false);				
-				GxElemSetPreference(contact->collided, opref);
+				opos.y -= physicsPush(self, contact->collided, GxContactDown, (opos.y + opos.h) - (spos.y + move.y), spref);
 				contact->amove = (opos.y + opos.h) - spos.y;
 			}			
 			if(move.y <= contact->amove){
@@ -388,75 +1691,66 @@ static inline GxVector physicsProcessMovementData(GxPhysics* self) {
 	GxElemExecuteMove_(emdata->self, move);
 	physicsApplyFriction(self, emdata->self, move);
 
-	//now check effective collisions and add to self collision array
-	Uint32 previousSize = GxArraySize(self->contacts);
+	//now check effective collisions and keep the new ones at the front of emdata->contacts
+	Uint32 added = 0;
 
-	double xres = 0.0, yres = 0.0; //restitution in direction x and y
-	bool changeVelocity = false;
+	Sint32 xres = 0, yres = 0; //restitution in direction x and y, in fixed point
+	bool changeVelx = false, changeVely = false; //a blocking element was hit on that axis
 
-	for (Uint32 i = 0; i < GxArraySize(emdata->contacts); i++){
-		GxContact* contact = GxArrayAt(emdata->contacts, i); 		
+	for (Uint32 i = 0; i < emdata->ncontacts; i++){
+		GxContact* contact = emdata->contacts[i]; 		
 		int spref = GxElemGetPreference(contact->colliding);
 		int opref = GxElemGetPreference(contact->collided);
 		SDL_Rect spos = *GxElemGetPosition(contact->colliding);
-		SDL_Rect opos = *GxElemGetPosition(contact->collided);
 
-		if (opref >= spref) changeVelocity = true;
+		if (opref >= spref) {
+			if (contact->direction == GxContactRight || contact->direction == GxContactLeft) changeVelx = true;
+			else changeVely = true;
+		}
 
+		bool isNew = false;
 		if ((contact->prevented) && 
-			SDL_HasIntersection(&spos, &opos)) {			
-			physicsAddContact(self, contact);			
+			physicsOverlaps(contact->collided, &spos)) {			
+			isNew = physicsAddContact(self, contact);			
 		}
 		else if ((contact->direction == GxContactRight || contact->direction == GxContactLeft) && (move.x == contact->amove)) {
-			if (xres < GxElemGetRestitution(contact->collided))
-				xres = GxElemGetRestitution(contact->collided);
-			physicsAddContact(self, contact);	
+			if (xres < GxElemGetRestitution_(contact->collided))
+				xres = GxElemGetRestitution_(contact->collided);
+			isNew = physicsAddContact(self, contact);	
 		}
 		else if ((contact->direction == GxContactUp || contact->direction == GxContactDown) && (move.y == contact->amove)) {
-			if (yres < GxElemGetRestitution(contact->collided))
-				yres = GxElemGetRestitution(contact->collided);
-			physicsAddContact(self, contact);
+			if (yres < GxElemGetRestitution_(contact->collided))
+				yres = GxElemGetRestitution_(contact->collided);
+			isNew = physicsAddContact(self, contact);
 		}
 		else {
 			destroyContact(contact);
 		}
+		if (isNew) emdata->contacts[added++] = contact;
 	}
 		
-	if (changeVelocity) {		
-		if (horizontalCollision) {
-			GxElemApplyHozElasticity_(emdata->self, xres);			
-		}
-		if (verticalCollision) {
-			GxElemApplyVetElasticity_(emdata->self, yres);
-		}		
+	if (changeVelx && horizontalCollision) {
+		GxElemApplyHozElasticity_(emdata->self, xres);			
+	}
+	if (changeVely && verticalCollision) {
+		GxElemApplyVetElasticity_(emdata->self, yres);
 	}
 
-		//notify collision callback handler
-	while (previousSize < GxArraySize(self->contacts)) {
-		GxContact* contact = GxArrayAt(self->contacts, previousSize);
-		GxSceneOnContactBegin_(self->scene, contact);
-		previousSize++;
+	//notify collision callback handler, skipping contacts a previous handler has already ended
+	for (Uint32 i = 0; i < added; i++) {
+		GxContact* contact = emdata->contacts[i];
+		if (contact->effective) physicsContactEvent(self, GxEventContactBegin, contact);
 	}
 	return move;
 }
 
 bool physicsAddContact(GxPhysics* self, GxContact* contact) {	
 	
-	bool contains = false;
-
-	for (Uint32 i = 0; i < GxArraySize(self->contacts); i++){
-		GxContact* buffer = GxArrayAt(self->contacts, i);		
-		if (contactIsEqual(contact, buffer)) {
-			contains = true;
-			break;
-		}
-	}
-
-	if (!contains) {		
-		elemAddContact_(contact->colliding, contact);
-		elemAddContact_(contact->collided, contact);		
+	if (!physicsFindContact(self, contact)) {		
+		self->stats.allocations += elemAddContact_(contact->colliding, contact);
+		self->stats.allocations += elemAddContact_(contact->collided, contact);
 		contact->effective = true;
-		GxArrayPush(self->contacts, contact, NULL);			
+		physicsIndexContact(self, contact);			
 		return true;
 	}
 
@@ -466,18 +1760,26 @@ bool physicsAddContact(GxPhysics* self, GxContact* contact) {
 
 void physicsCheckContactEnd(GxPhysics* self, GxElement* element) {
 		
-	GxArray* contactsToRemove = GxCreateArray();
-	GxList* allContacts = GxElemGetContactList_(element);
+	Uint32 total;
+	GxContact* const* allContacts = GxElemGetContactArray_(element, &total);
+	GxContact** contactsToRemove = physicsArenaAlloc(self, total * sizeof(GxContact*));
+	Uint32 count = 0;
 	
-	for (GxContact* contact = GxListBegin(allContacts); contact != NULL;
-		contact = GxListNext(allContacts))
-	{	
+	for (Uint32 i = 0; i < total; i++) {
+		GxContact* contact = allContacts[i];
 		SDL_Rect spos = *GxElemGetPosition(contact->colliding);
 		SDL_Rect opos = *GxElemGetPosition(contact->collided);
 				
 		if (contact->prevented){			
-			if (!SDL_HasIntersection(&spos, &opos)) {
-				GxArrayPush(contactsToRemove, contact, (GxDestructor) destroyContact);
+			if (!physicsOverlaps(contact->collided, &spos)) {
+				contactsToRemove[count++] = contact;
+			}
+		}
+		else if (isGrid(contact->collided)) {
+			//a grid stays in contact while any solid cell touches that side
+			SDL_Rect strip = sideStrip(&spos, contact->direction);
+			if (!physicsOverlaps(contact->collided, &strip)) {
+				contactsToRemove[count++] = contact;
 			}
 		}
 		else if((bool) (contact->direction == GxContactRight || contact->direction == GxContactLeft)){
@@ -485,7 +1787,7 @@ void physicsCheckContactEnd(GxPhysics* self, GxElement* element) {
 			bool touchingOnXAxis = (contact->direction ==  GxContactRight) ?
 				spos.x + spos.w == opos.x : spos.x == opos.x + opos.w;
 			if (notInTheSameRow || !touchingOnXAxis) {
-				GxArrayPush(contactsToRemove, contact, (GxDestructor) destroyContact);
+				contactsToRemove[count++] = contact;
 			}			
 		}
 		else if((bool) (contact->direction == GxContactUp || contact->direction == GxContactDown)){
@@ -503,23 +1805,24 @@ void physicsCheckContactEnd(GxPhysics* self, GxElement* element) {
 			bool touchingOnYAxis = (contact->direction == GxContactUp) ?
 				spos.y + spos.h == opos.y : spos.y == opos.y + opos.h;
 			if (notInTheSameColumn || !touchingOnYAxis) {
-				GxArrayPush(contactsToRemove, contact, (GxDestructor) destroyContact);
+				contactsToRemove[count++] = contact;
 			}
 		}
 	}
 	
-	for (Uint32 i = 0; i < GxArraySize(contactsToRemove); i++){
-		GxContact* contact = GxArrayAt(contactsToRemove, i);		
-		GxSceneOnContactEnd_(self->scene, contact);		
+	for (Uint32 i = 0; i < count; i++){
+		physicsContactEvent(self, GxEventContactEnd, contactsToRemove[i]);		
 	}
 	
-	//... GxArray destructor delete contacts //-> and GxContact GxDestructor remove it from arrays.
-	GxDestroyArray(contactsToRemove);
+	//destroyContact removes the contacts from the elements as well. The end handlers may
+	//have removed an element, which already destroyed its contacts
+	for (Uint32 i = 0; i < count; i++){
+		if (contactsToRemove[i]->effective) destroyContact(contactsToRemove[i]);
+	}
 }
 
-static void physicsCheckGround(GxElement* other) {
-	GxPhysics* physics = GxSceneGetPhysics(GxElemGetScene(other));
-	EmData* emdata = GxArrayLast(physics->emdstack);
+static void physicsCheckGround(GxPhysics* physics, GxElement* other) {
+	EmData* emdata = physics->emdata;
 	GxElement* self = emdata->self;
 	
 	const SDL_Rect* s = GxElemGetPosition(self);
@@ -527,11 +1830,15 @@ static void physicsCheckGround(GxElement* other) {
 
 	bool samecolumn =  !(s->x >= o->x + o->w || s->x + s->w <= o->x);
 	bool ytouching =  (s->y == o->y + o->h);
+	if (isGrid(other)) {
+		SDL_Rect strip = sideStrip(s, GxContactDown);
+		samecolumn = ytouching = physicsOverlaps(other, &strip);
+	}
 	if (samecolumn && ytouching) {
-		GxContact* contact = createContact(self, other, 0, GxContactDown);
+		GxContact* contact = createContact(physics, self, other, 0, GxContactDown);
 		GxSceneOnPreContact_(physics->scene, contact);
 		if (physicsAddContact(physics, contact)) {
-			GxSceneOnContactBegin_(physics->scene, contact);
+			physicsContactEvent(physics, GxEventContactBegin, contact);
 		}
 	}
 }
@@ -558,6 +1865,255 @@ void GxPhysicsCreateWalls_(GxPhysics* self) {
 	GxElemSetCmask(GxCreateElement(&ini), GxCmaskAll);
 }
 
+//... SNAPSHOTS
+//Contacts are saved with the elements that hold them, in the order each element holds them,
+//so the elements find them in the same order after a restore. Every contact is listed by both
+//its elements and the first one restored creates it again.
+typedef struct PhysicsState {
+	Uint32 pass;
+	Uint32 nspairs;
+	Uint32 nmoved;
+	Uint32 ndirty;
+} PhysicsState;
+
+typedef struct ContactState {
+	Uint32 colliding;
+	Uint32 collided;
+	Uint32 direction;
+	int amove;
+	bool prevented;
+} ContactState;
+
+static inline void idsRestore(GxPhysics* self, IdBuffer* buffer, const GxSnapshot* snapshot, size_t* offset, Uint32 size) {
+	if (size > buffer->capacity) {
+		buffer->capacity = size;
+		buffer->ids = realloc(buffer->ids, buffer->capacity * sizeof(Uint32));
+		GxAssertAllocationFailure(buffer->ids);
+		self->stats.allocations++;
+	}
+	GxSnapshotRead_(snapshot, offset, buffer->ids, size * sizeof(Uint32));
+	buffer->size = size;
+}
+
+void GxPhysicsSaveSnapshot_(GxPhysics* self, GxSnapshot* snapshot) {
+	GxAssertInvalidOperation(!self->resolving);
+	PhysicsState state = { self->pass, self->nspairs, self->smoved.size, self->sdirty.size };
+	GxSnapshotWrite_(snapshot, &state, sizeof(PhysicsState));
+	GxSnapshotWrite_(snapshot, self->spairs, self->nspairs * sizeof(SensorPair));
+	GxSnapshotWrite_(snapshot, self->smoved.ids, self->smoved.size * sizeof(Uint32));
+	GxSnapshotWrite_(snapshot, self->sdirty.ids, self->sdirty.size * sizeof(Uint32));
+}
+
+void GxPhysicsRestoreSnapshot_(GxPhysics* self, const GxSnapshot* snapshot, size_t* offset) {
+	GxAssertInvalidOperation(!self->resolving);
+	PhysicsState state;
+	GxSnapshotRead_(snapshot, offset, &state, sizeof(PhysicsState));
+	self->pass = state.pass;
+	self->version++;
+	if (state.nspairs > self->cspairs) {
+		self->cspairs = state.nspairs;
+		self->spairs = realloc(self->spairs, self->cspairs * sizeof(SensorPair));
+		GxAssertAllocationFailure(self->spairs);
+		self->stats.allocations++;
+	}
+	GxSnapshotRead_(snapshot, offset, self->spairs, state.nspairs * sizeof(SensorPair));
+	self->nspairs = state.nspairs;
+	idsRestore(self, &self->smoved, snapshot, offset, state.nmoved);
+	idsRestore(self, &self->sdirty, snapshot, offset, state.ndirty);
+
+	//every contact goes back to the pool, the elements restore theirs next
+	for (Uint32 i = 0; i < self->ccapacity; i++) {
+		GxContact* contact = self->ctable[i];
+		if (!contact) continue;
+		contact->hash = 0;
+		contact->effective = false;
+		contact->next = self->cpool;
+		self->cpool = contact;
+		self->ctable[i] = NULL;
+	}
+	self->csize = 0;
+}
+
+void GxPhysicsSaveContacts_(GxPhysics* self, GxElement* element, GxSnapshot* snapshot) {
+	Uint32 count;
+	GxContact* const* contacts = GxElemGetContactArray_(element, &count);
+	GxSnapshotWrite_(snapshot, &count, sizeof(Uint32));
+	for (Uint32 i = 0; i < count; i++) {
+		ContactState state = {
+			GxElemGetId(contacts[i]->colliding),
+			GxElemGetId(contacts[i]->collided),
+			contacts[i]->direction,
+			contacts[i]->amove,
+			contacts[i]->prevented,
+		};
+		GxSnapshotWrite_(snapshot, &state, sizeof(ContactState));
+	}
+}
+
+void GxPhysicsRestoreContacts_(GxPhysics* self, GxElement* element, const GxSnapshot* snapshot, size_t* offset) {
+	Uint32 count;
+	GxSnapshotRead_(snapshot, offset, &count, sizeof(Uint32));
+	ArenaMark mark = physicsArenaMark(self);
+	GxContact** contacts = physicsArenaAlloc(self, count * sizeof(GxContact*));
+	for (Uint32 i = 0; i < count; i++) {
+		ContactState state;
+		GxSnapshotRead_(snapshot, offset, &state, sizeof(ContactState));
+		GxContact key = {
+			.colliding = GxSceneGetElement(self->scene, state.colliding),
+			.collided = GxSceneGetElement(self->scene, state.collided),
+			.direction = state.direction,
+		};
+		GxAssertInvalidOperation(key.colliding && key.collided);
+		GxContact* contact = physicsFindContact(self, &key);
+		if (!contact) {
+			contact = createContact(self, key.colliding, key.collided, state.amove, state.direction);
+			contact->prevented = state.prevented;
+			contact->effective = true;
+			physicsIndexContact(self, contact);
+		}
+		contacts[i] = contact;
+	}
+	self->stats.allocations += GxElemSetContacts_(element, contacts, count);
+	physicsArenaRelease(self, mark);
+}
+
+void GxPhysicsRestoreElement_(GxPhysics* self, GxElement* element, SDL_Rect previousPos, bool moved, bool filtered) {
+	//the trees take the restored position and filter, the sensor lists and the pass were
+	//restored with the physics state and stay untouched
+	if (!GxElemIsPhysical(element)) return;
+	if (GxElemIsSensor(element)) {
+		if (moved) GxBroadphaseUpdate_(self->sensors, element, previousPos);
+		if (filtered) GxBroadphaseRefresh_(self->sensors, element);
+		return;
+	}
+	if (moved) GxBroadphaseUpdate_(self->fixed, element, previousPos);
+	if (filtered) GxBroadphaseRefresh_(self->fixed, element);
+	if (GxElemHasDynamicBody(element)) {
+		if (moved) GxBroadphaseUpdate_(self->dynamic, element, previousPos);
+		if (filtered) GxBroadphaseRefresh_(self->dynamic, element);
+	}
+}
+
+//... SPATIAL QUERIES
+//Queries read the fixed tree, which holds every physical element. They write at most capacity
+//results and return how many were found, so a return value above capacity means truncation.
+static inline bool rayHitRect(SDL_Point from, SDL_Point to, GxElement* elem, const SDL_Rect* pos, GxRayHit* hit) {
+	int x1 = from.x, y1 = from.y, x2 = to.x, y2 = to.y;
+	if (!SDL_IntersectRectAndLine(pos, &x1, &y1, &x2, &y2)) return false;
+
+	//the clipped segment starts where the ray enters the element
+	int dx = abs(to.x - from.x), dy = abs(to.y - from.y);
+	int length = dx > dy ? dx : dy;
+	int entry = dx > dy ? abs(x1 - from.x) : abs(y1 - from.y);
+	hit->elem = elem;
+	hit->point = (SDL_Point) { x1, y1 };
+	hit->fraction = length ? (double) entry / length : 0.0;
+
+	if (from.x < pos->x && x1 == pos->x) hit->direction = GxContactLeft;
+	else if (from.x >= pos->x + pos->w && x1 == pos->x + pos->w - 1) hit->direction = GxContactRight;
+	else if (from.y < pos->y && y1 == pos->y) hit->direction = GxContactDown;
+	else if (from.y >= pos->y + pos->h && y1 == pos->y + pos->h - 1) hit->direction = GxContactUp;
+	else hit->direction = 0;
+	return true;
+}
+
+static inline bool rayHitElement(SDL_Point from, SDL_Point to, GxElement* elem, GxRayHit* hit) {
+	if (!isGrid(elem)) return rayHitRect(from, to, elem, GxElemGetPosition(elem), hit);
+
+	//the nearest solid cell inside the bounds of the segment
+	SDL_Rect bounds = { 
+		from.x < to.x ? from.x : to.x, 
+		from.y < to.y ? from.y : to.y, 
+		abs(to.x - from.x) + 1, 
+		abs(to.y - from.y) + 1 
+	};
+	GridSpan span;
+	if (!gridSpan(elem, &bounds, &span)) return false;
+	bool found = false;
+	for (int row = span.r0; row <= span.r1; row++) {
+		for (int col = span.c0; col <= span.c1; col++) {
+			GxRayHit cell;
+			SDL_Rect rect = gridCell(&span, row, col);
+			if (!gridSolid(&span, row, col) || !rayHitRect(from, to, elem, &rect, &cell)) continue;
+			if (!found || cell.fraction < hit->fraction) *hit = cell;
+			found = true;
+		}
+	}
+	return found;
+}
+
+static int rayHitCompare(const void* lhs, const void* rhs) {
+	const GxRayHit* l = lhs;
+	const GxRayHit* r = rhs;
+	if (l->fraction != r->fraction) return l->fraction < r->fraction ? -1 : 1;
+	Uint32 lid = GxElemGetId(l->elem), rid = GxElemGetId(r->elem);
+	return (lid > rid) - (lid < rid);
+}
+
+static inline void physicsCollectRay(GxPhysics* self, SDL_Point from, SDL_Point to, Uint32 cmask) {
+	self->stats.queries++;
+	self->squery.size = 0;
+	GxBroadphaseCollectSegment_(self->fixed, from, to, (GxBroadphaseFilter) { cmask, ~0u }, &self->squery);
+	GxElemBufferSortUnique_(&self->squery);
+}
+
+bool GxPhysicsRaycastFirst_(GxPhysics* self, SDL_Point from, SDL_Point to, Uint32 cmask, GxRayHit* hit) {
+	//only the closest hit is kept, ties go to the lowest id as in GxPhysicsRaycast_
+	physicsCollectRay(self, from, to, cmask);
+	GxRayHit best, current;
+	bool found = false;
+	for (Uint32 i = 0; i < self->squery.size; i++) {
+		if (!rayHitElement(from, to, self->squery.elems[i], &current)) continue;
+		if (!found || rayHitCompare(&current, &best) < 0) best = current;
+		found = true;
+	}
+	if (found && hit) *hit = best;
+	return found;
+}
+
+int GxPhysicsRaycast_(GxPhysics* self, SDL_Point from, SDL_Point to, Uint32 cmask, 
+	GxRayHit* hits, int capacity) 
+{
+	GxAssertInvalidArgument(capacity >= 0 && (hits || !capacity));
+	physicsCollectRay(self, from, to, cmask);
+
+	Uint32 count = 0;
+	for (Uint32 i = 0; i < self->squery.size; i++) {
+		GxElement* elem = self->squery.elems[i];
+		if (count == self->rhcapacity) {
+			self->rhcapacity = self->rhcapacity ? self->rhcapacity * 2 : 16;
+			self->rhits = realloc(self->rhits, self->rhcapacity * sizeof(GxRayHit));
+			GxAssertAllocationFailure(self->rhits);
+			self->stats.allocations++;
+		}
+		if (rayHitElement(from, to, elem, &self->rhits[count])) count++;
+	}
+
+	qsort(self->rhits, count, sizeof(GxRayHit), rayHitCompare);
+	memcpy(hits, self->rhits, ((Uint32) capacity < count ? (Uint32) capacity : count) * sizeof(GxRayHit));
+	return (int) count;
+}
+
+int GxPhysicsQueryRect_(GxPhysics* self, SDL_Rect area, Uint32 cmask, GxElement** elems, int capacity) {
+	GxAssertInvalidArgument(capacity >= 0 && (elems || !capacity));
+	self->stats.queries++;
+	self->squery.size = 0;
+	GxBroadphaseCollectFiltered_(self->fixed, area, (GxBroadphaseFilter) { cmask, ~0u }, &self->squery);
+	GxElemBufferSortUnique_(&self->squery);
+
+	//tile grids only count where a solid cell is inside the area
+	Uint32 kept = 0;
+	for (Uint32 i = 0; i < self->squery.size; i++) {
+		GxElement* elem = self->squery.elems[i];
+		if (!isGrid(elem) || physicsOverlaps(elem, &area)) self->squery.elems[kept++] = elem;
+	}
+	self->squery.size = kept;
+
+	int count = (int) self->squery.size;
+	memcpy(elems, self->squery.elems, (capacity < count ? capacity : count) * sizeof(GxElement*));
+	return count;
+}
+
 #define CHECK_CONTACT_HASH(contact)\
 {\
 	uint32_t hash = *(uint32_t *) contact;\
@@ -2,6 +2,18 @@
 #define GX_PHYSICS_H
 #include "../Utilities/GxUtil.h"
 
+//cumulative counters of a scene's physics, read by the benchmark
+typedef struct GxPhysicsStats {
+	Uint64 updates;
+	Uint64 bodies; //dynamic bodies resolved
+	Uint64 contacts; //contacts created, including the ones discarded right away
+	Uint64 queries; //broadphase queries
+	Uint64 allocations; //heap allocations of the physics module, its indexes and query buffers
+	Uint64 counter; //time spent in GxPhysicsUpdate_, in performance counter units
+	Uint32 nodes; //nodes or grid cells of the fixed index when the stats were read
+	int depth; //depth of the fixed index when the stats were read, 0 for grids
+} GxPhysicsStats;
+
 //constructor and destructors
 GxPhysics* GxCreatePhysics_(GxScene* scene);
 void GxDestroyPhysics_(GxPhysics* self);
@@ -10,9 +22,27 @@ void GxDestroyPhysics_(GxPhysics* self);
 void GxPhysicsUpdate_(GxPhysics* self);
 void GxPhysicsInsertElement_(GxPhysics* self, GxElement* element);
 void GxPhysicsRemoveElement_(GxPhysics* self, GxElement* element);
+void GxPhysicsRefreshElement_(GxPhysics* self, GxElement* element);
+void GxPhysicsCheckContacts_(GxPhysics* self, GxElement* element);
 void GxPhysicsUpdateElementPosition_(GxPhysics* self, GxElement* element, SDL_Rect previousPos);
-GxVector GxPhysicsMoveCalledByElem_(GxPhysics* self, GxElement* element);
+GxVector GxPhysicsMoveCalledByElem_(GxPhysics* self, GxElement* element, bool force);
 void GxPhysicsCreateWalls_(GxPhysics* self);
+GxPhysicsStats GxPhysicsGetStats_(GxPhysics* self);
+void GxPhysicsRebalance_(GxPhysics* self);
+
+//snapshots
+void GxPhysicsSaveSnapshot_(GxPhysics* self, GxSnapshot* snapshot);
+void GxPhysicsRestoreSnapshot_(GxPhysics* self, const GxSnapshot* snapshot, size_t* offset);
+void GxPhysicsSaveContacts_(GxPhysics* self, GxElement* element, GxSnapshot* snapshot);
+void GxPhysicsRestoreContacts_(GxPhysics* self, GxElement* element, const GxSnapshot* snapshot, size_t* offset);
+void GxPhysicsRestoreElement_(GxPhysics* self, GxElement* element, SDL_Rect previousPos, bool moved, bool filtered);
+
+//spatial queries
+bool GxPhysicsRaycastFirst_(GxPhysics* self, SDL_Point from, SDL_Point to, Uint32 cmask, GxRayHit* hit);
+int GxPhysicsRaycast_(GxPhysics* self, SDL_Point from, SDL_Point to, Uint32 cmask, 
+	GxRayHit* hits, int capacity
+);
+int GxPhysicsQueryRect_(GxPhysics* self, SDL_Rect area, Uint32 cmask, GxElement** elems, int capacity);
 
 //contact methods
 GxElement* GxContactGetColliding(GxContact* contact);
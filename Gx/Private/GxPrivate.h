@@ -12,6 +12,10 @@ typedef struct GxElement {
 	GxArray* classList;
 	GxScene* scene;
 	SDL_Rect* pos;
+
+	//position before the last tick moved the element, used to interpolate rendering
+	SDL_Point lastPos;
+	Uint32 lastTick;
 	
 	//modules
 	GxRenderable* renderable;
@@ -66,7 +66,7 @@ typedef struct GxMatrix {
 typedef struct GxEvent {
 	void* target;
 	int type;
-	union { GxContact* contact; SDL_Event* sdle; };
+	union { GxContact* contact; SDL_Event* sdle; GxElement* other; };
 } GxEvent;
 
 typedef union GxData {
@@ -87,6 +87,21 @@ typedef union GxData {
 	GxMatrix matrix;
 } GxData;
 
+typedef struct GxRayHit {
+	GxElement* elem;
+	SDL_Point point; //where the ray enters the element
+	double fraction; //0 at the origin of the ray, 1 at its end
+	Uint32 direction; //side of the element that was hit, 0 when the ray starts inside it
+} GxRayHit;
+
+//simulation state of a scene in one contiguous buffer, reused by every save into it.
+//It only holds for the running app, since it keeps pointers to the scene and its timers
+typedef struct GxSnapshot {
+	void* data;
+	size_t size;
+	size_t capacity;
+} GxSnapshot;
+
 typedef struct GxRequest {
 	void* target;
 	const char* request;
@@ -113,6 +128,9 @@ static inline void GxAssertion_(bool condition, const char* error) {
 #define	GxCmaskDynamic 1 << 0
 #define	GxCmaskFixed (1 << 0 | 1 << 1 | 1 << 2 | 1 << 3 | 1 << 4 | 1 << 5 | 1 << 6 | 1 << 7)
 
+#define GxLayerMax 32
+#define GxLayerDefault "default"
+
 #define GxButtonKeyboard (1u << 0)
 #define	GxButtonFinger (1u << 1)
 #define	GxButtonMouse (1u << 2)
@@ -137,6 +155,11 @@ typedef enum GxContactConstant {
 	GxContactAll = 1 << 0 | 1 << 1 | 1 << 2 | 1 << 3 | 1 << 4,
 } GxContactConstant;
 
+typedef enum GxBroadphaseType {
+	GxBroadphaseQuadtree, //the default
+	GxBroadphaseGrid, //hashed uniform grid, for crowds of elements of similar size
+} GxBroadphaseType;
+
 typedef enum GxStatus {
 	GxStatusNone,
 	GxStatusLoading,
@@ -169,6 +192,8 @@ typedef enum GxEventType {
 	GxEventPreContact,
 	GxEventContactBegin,
 	GxEventContactEnd,
+	GxEventSensorEnter,
+	GxEventSensorExit,
 
 	//events not inside ihandlers
 	GxEventTimeout,
@@ -186,6 +211,9 @@ enum GxElemConstants {
 	GxElemRelative = 3,	
 	GxElemFixed = 4,
 	GxElemDynamic = 5,	
+	GxElemGrid = 6, //tilemaps only, one collider made of the solid tiles
+	GxElemMerged = 7, //tilemaps only, solid tiles merged into fixed bodies
+	GxElemSensor = 8, //reports the dynamic bodies that enter and exit it, never collides
 	GxElemForward = SDL_FLIP_NONE,
 	GxElemBackward = SDL_FLIP_HORIZONTAL,
 };
@@ -1,207 +1,600 @@
 #include "../Utilities/GxUtil.h"
 #include "../Quadtree/GxQuadtree.h"
-#include "../List/GxList.h"
-#include "../Array/GxArray.h"
 #include <stdint.h>
 #include "../Element/GxElement.h"
 #include "../Renderable/GxRenderable.h"
 #include "../RigidBody/GxRigidBody.h"
 #include <string.h>
+#include <stdlib.h>
 
 //... type
-typedef struct GxQtree {
-	const char* type;
-	GxQtree* parent;	
+typedef struct QtreeEntry {
+	GxElement* elem;
+	//position and collision filter cached from the element, so queries do not touch it
+	SDL_Rect pos;
+	Uint32 cmask;
+	Uint32 layer; //layer bit
+} QtreeEntry;
+
+//nodes live in one pool and refer to each other by index, the four children of a node
+//are consecutive. Merged children go back to the pool as a block, and entry arrays stay
+//with their node, so a warm tree never allocates
+typedef struct QtreeNode {
 	SDL_Rect pos;
-	GxArray* children;
-	GxList* elements;
+	Uint32 parent; //next free block while the node is in the pool
+	Uint32 children; //index of the first child, 0 for leaves since the root is never a child
+	QtreeEntry* entries;
+	int size;
+	int capacity;
+} QtreeNode;
+
+//back-reference from an element to the deepest node holding all of its entries, so moves
+//start there instead of at the root
+typedef struct QtreeHome {
+	GxElement* elem; //NULL for free slots
+	Uint32 node;
+} QtreeHome;
+
+typedef struct GxQtree {
+	QtreeNode* nodes;
+	Uint32 nnodes;
+	Uint32 cnodes;
+	Uint32 free; //first free block of four nodes, 0 when there is none
+	bool loose; //each element lives in the single node chosen by its center and size
+
+	//homes of the elements, open addressing keyed by the element, the capacity is a power of two
+	QtreeHome* homes;
+	Uint32 nhomes;
+	Uint32 chomes;
+	Uint64 allocations; //growths since creation, for the stats
 } GxQtree;
 
 //static
-static uint32_t gWCounter = 0;
-static uint32_t gFCounter = 0;
-static uint32_t gDCounter = 0;
 static const int kMaxElements = 10;
 static const int kMinLength = 100;
+static const int kMergeElements = 5; //four leaves holding fewer entries merge, half of kMaxElements
+static const Uint32 kRoot = 0;
+static const Uint32 kMinHomes = 64;
 
-static const char* sGraphical = "graphical";
-static const char* sDynamic = "dynamic";
-static const char* sFixed = "fixed";
+static inline void qtreeInitNode(QtreeNode* node, Uint32 parent, SDL_Rect pos) {
+	//the entry array is kept, since the node may come back from the pool
+	node->pos = pos;
+	node->parent = parent;
+	node->children = 0;
+	node->size = 0;
+}
 
-GxQtree* GxCreateQtree_(GxQtree* parent, SDL_Rect pos, const char* type){		
+GxQtree* GxCreateQtree_(SDL_Rect pos, bool loose){		
 	GxQtree* self = malloc(sizeof(GxQtree));
 	GxAssertAllocationFailure(self);
-	self->parent = parent;
-	
-	if (type == sGraphical || strcmp(type, "graphical") == 0) {
-		self->type = sGraphical;
-	}
-	else if (type == sFixed || strcmp(type, "fixed") == 0) {
-		self->type = sFixed;
-	}
-	else if (type == sDynamic || strcmp(type, "dynamic") == 0) {
-		self->type = sDynamic;
-	}
 	
-	self->type = type;
-	self->pos = pos;	
-	self->children = NULL;
-	self->elements = NULL;
+	self->cnodes = 1 + 4 * 16;
+	self->nodes = malloc(self->cnodes * sizeof(QtreeNode));
+	GxAssertAllocationFailure(self->nodes);
+	self->nnodes = 1;
+	self->free = 0;
+	self->loose = loose;
+	self->nhomes = 0;
+	self->chomes = kMinHomes;
+	self->allocations = 0;
+	self->homes = calloc(self->chomes, sizeof(QtreeHome));
+	GxAssertAllocationFailure(self->homes);
+	self->nodes[kRoot].entries = NULL;
+	self->nodes[kRoot].capacity = 0;
+	qtreeInitNode(&self->nodes[kRoot], kRoot, pos);
 	return self;
 }
 
 void GxDestroyQtree_(GxQtree* self) {
 	if (self) {
-		if (self->children) GxDestroyArray(self->children);
-		if (self->elements) GxDestroyList(self->elements);
+		for (Uint32 i = 0; i < self->nnodes; i++) free(self->nodes[i].entries);
+		free(self->nodes);
+		free(self->homes);
 		free(self);
 	}
 }
 
-//acessors and mutators
-SDL_Rect GxQtreeGetPosition_(GxQtree* self) {
-	return self->pos;
+//... ENTRIES
+static inline QtreeEntry createEntry(GxElement* elem) {
+	const SDL_Rect* pos = GxElemGetPosition(elem);
+	if (!GxElemIsPhysical(elem)) return (QtreeEntry) { elem, *pos, 0, 0 };
+	return (QtreeEntry) { elem, *pos, GxElemGetCmask(elem), 1u << GxElemGetLayer_(elem) };
 }
 
-//methods
-void GxQtreeInsert_(GxQtree* self, GxElement* element) {
+static inline int qtreeFind(const QtreeNode* node, GxElement* elem) {
+	for (int i = 0; i < node->size; i++) {
+		if (node->entries[i].elem == elem) return i;
+	}
+	return -1;
+}
 
-	SDL_Rect elemPos = *GxElemGetPosition(element);
-		
-	if (SDL_HasIntersection(&self->pos, &elemPos)) {
+static inline void qtreePush(GxQtree* self, QtreeNode* node, QtreeEntry entry) {
+	if (node->size == node->capacity) {
+		node->capacity = node->capacity ? node->capacity * 2 : kMaxElements;
+		node->entries = realloc(node->entries, node->capacity * sizeof(QtreeEntry));
+		GxAssertAllocationFailure(node->entries);
+		self->allocations++;
+	}
+	node->entries[node->size++] = entry;
+}
 
-		if (self->children) {
-			for (Uint32 i = 0; i < GxArraySize(self->children); i++) {
-				GxQtree* child = GxArrayAt(self->children, i);
-				GxQtreeInsert_(child, element);
-			}
-		}
-		else if (!self->elements) {			
-			self->elements = GxCreateList();
-			GxListPush(self->elements, element, NULL);				
+static inline void qtreeErase(QtreeNode* node, GxElement* elem) {
+	//keeps the order, as removing from the former element list did
+	int i = qtreeFind(node, elem);
+	if (i < 0) return;
+	memmove(&node->entries[i], &node->entries[i + 1], (node->size - i - 1) * sizeof(QtreeEntry));
+	node->size--;
+}
+
+static inline bool entryPasses(const QtreeEntry* entry, const GxBroadphaseFilter* filter) {
+	return !filter || ((entry->cmask & filter->cmask) && (entry->layer & filter->layers));
+}
+
+//... HOMES
+static inline Uint32 homeHash(const GxElement* elem) {
+	//elements share an allocation stride, the high bits of the product are folded down so
+	//the table mask does not only see the bits the stride leaves fixed
+	uint64_t key = (uint64_t) (uintptr_t) elem;
+	Uint32 hash = (Uint32) (key ^ (key >> 32)) * 2654435761u;
+	return hash ^ (hash >> 16);
+}
+
+static inline QtreeHome* homeFind(const GxQtree* self, const GxElement* elem) {
+	Uint32 mask = self->chomes - 1;
+	for (Uint32 i = homeHash(elem) & mask; self->homes[i].elem; i = (i + 1) & mask) {
+		if (self->homes[i].elem == elem) return &self->homes[i];
+	}
+	return NULL;
+}
+
+static inline Uint32 homeGet(const GxQtree* self, const GxElement* elem) {
+	//the root holds every element, so it is the home of the ones without a record
+	const QtreeHome* home = homeFind(self, elem);
+	return home ? home->node : kRoot;
+}
+
+static void homeSet(GxQtree* self, GxElement* elem, Uint32 node) {
+	QtreeHome* home = homeFind(self, elem);
+	if (home) {
+		home->node = node;
+		return;
+	}
+
+	if ((self->nhomes + 1) * 2 > self->chomes) {
+		QtreeHome* homes = self->homes;
+		Uint32 chomes = self->chomes;
+		self->chomes *= 2;
+		self->homes = calloc(self->chomes, sizeof(QtreeHome));
+		GxAssertAllocationFailure(self->homes);
+		self->allocations++;
+		self->nhomes = 0;
+		for (Uint32 i = 0; i < chomes; i++) {
+			if (homes[i].elem) homeSet(self, homes[i].elem, homes[i].node);
 		}
-		else if (GxListSize(self->elements) < kMaxElements ||			
-			(self->pos.w / 2) < kMinLength) {
-			if(!GxListContains(self->elements, element)) GxListPush(self->elements, element, NULL);
+		free(homes);
+	}
+
+	Uint32 mask = self->chomes - 1;
+	Uint32 i = homeHash(elem) & mask;
+	while (self->homes[i].elem) i = (i + 1) & mask;
+	self->homes[i] = (QtreeHome) { elem, node };
+	self->nhomes++;
+}
+
+static void homeErase(GxQtree* self, GxElement* elem) {
+	QtreeHome* home = homeFind(self, elem);
+	if (!home) return;
+
+	//the records after it move back into the gap, so lookups never need tombstones
+	Uint32 mask = self->chomes - 1;
+	Uint32 gap = (Uint32) (home - self->homes);
+	for (Uint32 i = (gap + 1) & mask; self->homes[i].elem; i = (i + 1) & mask) {
+		Uint32 ideal = homeHash(self->homes[i].elem) & mask;
+		if (((i - ideal) & mask) >= ((i - gap) & mask)) {
+			self->homes[gap] = self->homes[i];
+			gap = i;
 		}
-		else if (GxListSize(self->elements) >= kMaxElements) {			
-			//first subdivide
-			GxQtreeSubdivide_(self);
-			//then, insert element recursively
-			GxQtreeInsert_(self, element);
+	}
+	self->homes[gap].elem = NULL;
+	self->nhomes--;
+}
+
+//... NODES
+static inline bool rectsIntersect(const SDL_Rect* a, const SDL_Rect* b) {
+	//same test as SDL_HasIntersection, without the call
+	return a->w > 0 && a->h > 0 && b->w > 0 && b->h > 0 &&
+		a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static inline bool pointInRect(int x, int y, const SDL_Rect* rect) {
+	return x >= rect->x && x < rect->x + rect->w && y >= rect->y && y < rect->y + rect->h;
+}
+
+static inline SDL_Rect qtreeBounds(const GxQtree* self, Uint32 index) {
+	//a loose node holds elements reaching half its size past its borders
+	SDL_Rect pos = self->nodes[index].pos;
+	if (!self->loose) return pos;
+	return (SDL_Rect) { pos.x - pos.w / 2, pos.y - pos.h / 2, pos.w * 2, pos.h * 2 };
+}
+
+static inline bool qtreeReaches(const GxQtree* self, Uint32 index, const SDL_Rect* area) {
+	//the loose root also holds the elements whose center is outside the tree
+	if (self->loose && index == kRoot) return true;
+	SDL_Rect bounds = qtreeBounds(self, index);
+	return rectsIntersect(&bounds, area);
+}
+
+static inline bool qtreeHolds(const GxQtree* self, Uint32 index, const SDL_Rect* pos) {
+	//a loose node holds the rects with their center in it and at most its size, a tight one
+	//the rects entirely inside it. The root holds everything
+	const SDL_Rect* node = &self->nodes[index].pos;
+	if (index == kRoot) return true;
+	if (self->loose) {
+		return pointInRect(pos->x + pos->w / 2, pos->y + pos->h / 2, node) && 
+			pos->w <= node->w && pos->h <= node->h;
+	}
+	return pos->x >= node->x && pos->y >= node->y && 
+		pos->x + pos->w <= node->x + node->w && pos->y + pos->h <= node->y + node->h;
+}
+
+static inline Uint32 qtreeClimb(const GxQtree* self, Uint32 index, const SDL_Rect* pos) {
+	while (!qtreeHolds(self, index, pos)) index = self->nodes[index].parent;
+	return index;
+}
+
+static inline Uint32 qtreeLocate(const GxQtree* self, Uint32 index, const SDL_Rect* pos) {
+	//descends from index to the deepest node holding pos, which is the node of its entry in
+	//a loose tree and the one all its leaves descend from in a tight tree
+	for (Uint32 first = self->nodes[index].children; first; first = self->nodes[index].children) {
+		Uint32 c = first;
+		while (c < first + 4 && !qtreeHolds(self, c, pos)) c++;
+		if (c == first + 4) break;
+		index = c;
+	}
+	return index;
+}
+
+static void qtreeInsert(GxQtree* self, Uint32 index, const QtreeEntry* entry);
+static void qtreeInsertLoose(GxQtree* self, Uint32 index, const QtreeEntry* entry);
+
+static inline Uint32 qtreeTakeBlock(GxQtree* self) {
+	//freed blocks are reused first, the pool may move otherwise
+	if (self->free) {
+		Uint32 first = self->free;
+		self->free = self->nodes[first].parent;
+		return first;
+	}
+	if (self->nnodes + 4 > self->cnodes) {
+		self->cnodes *= 2;
+		self->nodes = realloc(self->nodes, self->cnodes * sizeof(QtreeNode));
+		GxAssertAllocationFailure(self->nodes);
+		self->allocations++;
+	}
+	Uint32 first = self->nnodes;
+	self->nnodes += 4;
+	for (Uint32 c = first; c < first + 4; c++) {
+		self->nodes[c].entries = NULL;
+		self->nodes[c].capacity = 0;
+	}
+	return first;
+}
+
+static inline void qtreeFreeBlock(GxQtree* self, Uint32 first) {
+	for (Uint32 c = first; c < first + 4; c++) {
+		self->nodes[c].size = 0;
+		self->nodes[c].children = 0;
+	}
+	self->nodes[first].parent = self->free;
+	self->free = first;
+}
+
+static inline bool qtreeCollapse(GxQtree* self, Uint32 index, int threshold) {
+	//four leaf children holding fewer than threshold entries merge back into their parent,
+	//an element crossing several of them is kept once. Loose parents keep their own entries,
+	//and the elements whose home was a child move home to the parent
+	QtreeNode* node = &self->nodes[index];
+	Uint32 first = node->children;
+	int total = node->size;
+	for (Uint32 c = first; c < first + 4; c++) {
+		if (self->nodes[c].children) return false;
+		total += self->nodes[c].size;
+	}
+	if (total >= threshold) return false;
+
+	node->children = 0;
+	for (Uint32 c = first; c < first + 4; c++) {
+		const QtreeNode* child = &self->nodes[c];
+		for (int i = 0; i < child->size; i++) {
+			GxElement* elem = child->entries[i].elem;
+			if (self->loose || qtreeFind(node, elem) < 0) qtreePush(self, node, child->entries[i]);
+			QtreeHome* home = homeFind(self, elem);
+			if (home && home->node >= first && home->node < first + 4) home->node = index;
 		}
-	}	
+	}
+	qtreeFreeBlock(self, first);
+	return true;
 }
 
-void GxQtreeRemove_(GxQtree* self, GxElement* element) {	
-	SDL_Rect elemPos = *GxElemGetPosition(element);
-	if ((!self->elements && !self->children) || 
-		!SDL_HasIntersection(&self->pos, &elemPos)) return;
-	if (self->children) {
-		for (Uint32 i = 0; i < GxArraySize(self->children); i++) {
-			GxQtree* child = GxArrayAt(self->children, i);
-			GxQtreeRemove_(child, element);			
+static void qtreeSubdivide(GxQtree* self, Uint32 index) {
+
+	//the pool may move, so the node is fetched afterwards
+	Uint32 first = qtreeTakeBlock(self);
+	QtreeNode* node = &self->nodes[index];
+
+	int xm = node->pos.w / 2; //middle x direction
+	int ym = node->pos.h / 2; // middle y direction
+	int xdif = node->pos.w % 2; // variable to adjust child size in case of odd parent size x direction
+	int ydif = node->pos.h % 2; // variable to adjust child size in case of odd parent size y direction
+	SDL_Rect pos = node->pos;
+
+	qtreeInitNode(&self->nodes[first], index, (SDL_Rect) { pos.x, pos.y, xm, ym });
+	qtreeInitNode(&self->nodes[first + 1], index, (SDL_Rect) { pos.x + xm, pos.y, xm + xdif, ym });
+	qtreeInitNode(&self->nodes[first + 2], index, (SDL_Rect) { pos.x, pos.y + ym, xm, ym + ydif });
+	qtreeInitNode(&self->nodes[first + 3], index, (SDL_Rect) { pos.x + xm, pos.y + ym, xm + xdif, ym + ydif });
+	node->children = first;
+
+	if (self->loose) {
+		//entries too big for the children stay, in order
+		int size = 0;
+		for (int i = 0; i < node->size; i++) {
+			QtreeEntry entry = node->entries[i];
+			Uint32 target = qtreeLocate(self, index, &entry.pos);
+			if (target == index) node->entries[size++] = entry;
+			else qtreeInsertLoose(self, target, &entry);
+			node = &self->nodes[index];
 		}
+		node->size = size;
+		return;
 	}
-	else GxListRemove(self->elements, element);
+
+	//then transfer all entries to the children, the node keeps its array for later use.
+	//The elements that were at home here move down when a child holds them entirely
+	for (int i = 0; i < node->size; i++) {
+		QtreeEntry entry = node->entries[i];
+		for (Uint32 c = first; c < first + 4; c++) qtreeInsert(self, c, &entry);
+		node = &self->nodes[index];
+		QtreeHome* home = homeFind(self, entry.elem);
+		if (home && home->node == index) home->node = qtreeLocate(self, index, &entry.pos);
+	}
+	node->size = 0;
 }
 
-void GxQtreeUpdate_(GxQtree* self, GxElement* element, SDL_Rect previous) {	
-	
-	SDL_Rect elemPos = *GxElemGetPosition(element);	
+static void qtreeInsert(GxQtree* self, Uint32 index, const QtreeEntry* entry) {
+
+	QtreeNode* node = &self->nodes[index];
+	if (!rectsIntersect(&node->pos, &entry->pos)) return;
+
+	if (node->children) {
+		Uint32 first = node->children;
+		for (Uint32 c = first; c < first + 4; c++) qtreeInsert(self, c, entry);
+	}
+	else if (!node->size) {			
+		qtreePush(self, node, *entry);
+	}
+	else if (node->size < kMaxElements || (node->pos.w / 2) < kMinLength) {
+		if (qtreeFind(node, entry->elem) < 0) qtreePush(self, node, *entry);
+	}
+	else {			
+		//first subdivide, then insert the entry recursively
+		qtreeSubdivide(self, index);
+		qtreeInsert(self, index, entry);
+	}
+}
+
+static void qtreeInsertLoose(GxQtree* self, Uint32 index, const QtreeEntry* entry) {
+	index = qtreeLocate(self, index, &entry->pos);
+	QtreeNode* node = &self->nodes[index];
+	if (!node->children && node->size >= kMaxElements && (node->pos.w / 2) >= kMinLength) {
+		qtreeSubdivide(self, index);
+		index = qtreeLocate(self, index, &entry->pos);
+	}
+	qtreePush(self, &self->nodes[index], *entry);
+	homeSet(self, entry->elem, index);
+}
+
+static Uint32 qtreeCollapseUp(GxQtree* self, Uint32 index) {
+	//after a node lost entries, merges it and then its ancestors while they fit, and returns
+	//the highest node that absorbed its children, or index itself
+	if (self->nodes[index].children && !qtreeCollapse(self, index, kMergeElements)) return index;
+	while (index != kRoot) {
+		Uint32 parent = self->nodes[index].parent; //freeing the block overwrites it
+		if (!qtreeCollapse(self, parent, kMergeElements)) break;
+		index = parent;
+	}
+	return index;
+}
+
+static void qtreeRemove(GxQtree* self, Uint32 index, GxElement* element, const SDL_Rect* pos) {	
+	QtreeNode* node = &self->nodes[index];
+	if ((!node->size && !node->children) || !rectsIntersect(&node->pos, pos)) return;
+	if (node->children) {
+		for (Uint32 c = node->children; c < node->children + 4; c++) qtreeRemove(self, c, element, pos);
+		qtreeCollapse(self, index, kMergeElements);
+	}
+	else qtreeErase(node, element);
+}
+
+static void qtreeUpdate(GxQtree* self, Uint32 index, const QtreeEntry* entry, const SDL_Rect* previous) {	
 	
-	bool has = SDL_HasIntersection(&self->pos, &elemPos);
-	bool had = SDL_HasIntersection(&self->pos, &previous);
+	QtreeNode* node = &self->nodes[index];
+	bool has = rectsIntersect(&node->pos, &entry->pos);
+	bool had = rectsIntersect(&node->pos, previous);
 
-	if (self->children && (had || has)) {
-		for (Uint32 i = 0; i < GxArraySize(self->children); i++) {
-			GxQtree* child = GxArrayAt(self->children, i);
-			GxQtreeUpdate_(child, element, previous);
-		}
+	if (node->children && (had || has)) {
+		Uint32 first = node->children;
+		for (Uint32 c = first; c < first + 4; c++) qtreeUpdate(self, c, entry, previous);
+		qtreeCollapse(self, index, kMergeElements);
 	}
 	else if (had && !has) {
-		if (self->elements) GxListRemove(self->elements, element);
+		qtreeErase(node, entry->elem);
 	}
 	else if (!had && has) {
-		GxQtreeInsert_(self, element);
+		qtreeInsert(self, index, entry);
 	}	
+	else if (had && has) {
+		//the element stays in the leaf, only its cached position changes
+		int i = qtreeFind(node, entry->elem);
+		if (i >= 0) node->entries[i].pos = entry->pos;
+	}
+}
+
+static void qtreeRefresh(GxQtree* self, Uint32 index, const QtreeEntry* entry) {
+	QtreeNode* node = &self->nodes[index];
+	if (!rectsIntersect(&node->pos, &entry->pos)) return;
+	if (node->children) {
+		for (Uint32 c = node->children; c < node->children + 4; c++) qtreeRefresh(self, c, entry);
+	}
+	else {
+		int i = qtreeFind(node, entry->elem);
+		if (i >= 0) node->entries[i] = *entry;
+	}
+}
+
+static void qtreeRebalance(GxQtree* self, Uint32 index) {
+	//merges from the bottom up every subtree that fits in a single leaf
+	Uint32 first = self->nodes[index].children;
+	if (!first) return;
+	for (Uint32 c = first; c < first + 4; c++) qtreeRebalance(self, c);
+	qtreeCollapse(self, index, kMaxElements + 1);
+}
+
+static void qtreeStats(const GxQtree* self, Uint32 index, int depth, GxBroadphaseStats* stats) {
+	const QtreeNode* node = &self->nodes[index];
+	stats->nodes++;
+	stats->entries += (Uint32) node->size;
+	if (depth > stats->depth) stats->depth = depth;
+	if (node->children) {
+		for (Uint32 c = node->children; c < node->children + 4; c++) qtreeStats(self, c, depth + 1, stats);
+	}
+	else {
+		stats->leaves++;
+	}
 }
 
+//acessors and mutators
+SDL_Rect GxQtreeGetPosition_(GxQtree* self) {
+	return self->nodes[kRoot].pos;
+}
+
+GxBroadphaseStats GxQtreeGetStats_(GxQtree* self) {
+	GxBroadphaseStats stats = { 0 };
+	qtreeStats(self, kRoot, 0, &stats);
+	stats.allocations = self->allocations;
+	return stats;
+}
 
-void GxQtreeSubdivide_(GxQtree* self) {
+//methods
+void GxQtreeInsert_(GxQtree* self, GxElement* element) {
+	QtreeEntry entry = createEntry(element);
+	if (self->loose) {
+		qtreeInsertLoose(self, kRoot, &entry);
+		return;
+	}
+	qtreeInsert(self, kRoot, &entry);
+	homeSet(self, element, qtreeLocate(self, kRoot, &entry.pos));
+}
 
-	int xm = self->pos.w / 2; //middle x direction
-	int ym = self->pos.h / 2; // middle y direction
-	int xdif = self->pos.w % 2; // variable to adjust child size in case of odd parent size x direction
-	int ydif = self->pos.h % 2; // variable to adjust child size in case of odd parent size y direction
+void GxQtreeRemove_(GxQtree* self, GxElement* element) {	
+	const SDL_Rect* pos = GxElemGetPosition(element);
+	Uint32 index = qtreeClimb(self, homeGet(self, element), pos);
+	if (self->loose) qtreeErase(&self->nodes[index], element);
+	else qtreeRemove(self, index, element, pos);
+	homeErase(self, element);
+	qtreeCollapseUp(self, index);
+}
 
-	//caculate pos
-	SDL_Rect qtree01 = { self->pos.x, self->pos.y, xm, ym };
-	SDL_Rect qtree02 = { self->pos.x + xm, self->pos.y, xm + xdif, ym };
-	SDL_Rect qtree03 = { self->pos.x, self->pos.y + ym, xm, ym + ydif };
-	SDL_Rect qtree04 = { self->pos.x + xm, self->pos.y + ym, xm + xdif, ym + ydif };
+void GxQtreeUpdate_(GxQtree* self, GxElement* element, SDL_Rect previous) {	
+	
+	//the update starts at the element's home and only climbs to the lowest node holding
+	//both positions, so a move inside a leaf never touches the rest of the tree
+	QtreeEntry entry = createEntry(element);
+	Uint32 from = qtreeClimb(self, homeGet(self, element), &previous);
+	Uint32 start = qtreeClimb(self, from, &entry.pos);
 	
-	//create new qtrees and Push into children list
-	self->children = GxCreateArray();
-	GxArrayPush(self->children, GxCreateQtree_(self, qtree01, self->type), (GxDestructor) GxDestroyQtree_);
-	GxArrayPush(self->children, GxCreateQtree_(self, qtree02, self->type), (GxDestructor) GxDestroyQtree_);
-	GxArrayPush(self->children, GxCreateQtree_(self, qtree03, self->type), (GxDestructor) GxDestroyQtree_);
-	GxArrayPush(self->children, GxCreateQtree_(self, qtree04, self->type), (GxDestructor) GxDestroyQtree_);
+	if (!self->loose) {
+		qtreeUpdate(self, start, &entry, &previous);
+		start = qtreeCollapseUp(self, start);
+		homeSet(self, element, qtreeLocate(self, start, &entry.pos));
+		return;
+	}
 
-	//then transfer all entities to childrens
-	for (GxElement* elem = GxListBegin(self->elements); elem != NULL; 
-		elem = GxListNext(self->elements)) 
-	{
-		GxQtreeInsert_(self, elem);
+	//a move that keeps the element in its node only changes the cached position
+	Uint32 to = qtreeLocate(self, start, &entry.pos);
+	if (from == to) {
+		QtreeNode* node = &self->nodes[from];
+		int i = qtreeFind(node, element);
+		if (i >= 0) node->entries[i].pos = entry.pos;
+		return;
 	}
+	qtreeErase(&self->nodes[from], element);
+	//inserting first, a merge above the source could free the target otherwise
+	qtreeInsertLoose(self, to, &entry);
+	qtreeCollapseUp(self, from);
+}
 
-	//finally, delete and nullify self->elements
-	GxDestroyList(self->elements);
-	self->elements = NULL;
+void GxQtreeRefresh_(GxQtree* self, GxElement* element) {
+	QtreeEntry entry = createEntry(element);
+	Uint32 index = qtreeClimb(self, homeGet(self, element), &entry.pos);
+	if (self->loose) {
+		QtreeNode* node = &self->nodes[index];
+		int i = qtreeFind(node, element);
+		if (i >= 0) node->entries[i] = entry;
+	}
+	else qtreeRefresh(self, index, &entry);
 }
 
-void GxQtreeIterate_(GxQtree* self, SDL_Rect area, void(*callback)(GxElement*), bool begin) {
+void GxQtreeRebalance_(GxQtree* self) {
+	qtreeRebalance(self, kRoot);
+}
 
-	//I am not very sure if it works flawlessly or is just a big undefined behaviour
-	//The problem is I cannot imagine everything that can happen when the qtree is 
-	//subdivided in the iteration callback	
+static void qtreeCollect(const GxQtree* self, Uint32 index, const SDL_Rect* area, 
+	const GxBroadphaseFilter* filter, GxElemBuffer* out) 
+{
+	//only reads the tree and leaves deduplication to the caller (GxElemBufferSortUnique_),
+	//so it is reentrant and safe to run from several threads at once
+	const QtreeNode* node = &self->nodes[index];
+	if (!qtreeReaches(self, index, area)) return;
 
-	if (begin) {
-		if (self->type == sGraphical){
-			gWCounter++;
-		}
-		else if (self->type == sFixed){
-			gFCounter++;
-		}
-		else if (self->type == sDynamic){
-			gDCounter++;
+	for (int i = 0; i < node->size; i++) {
+		const QtreeEntry* entry = &node->entries[i];
+		if (entryPasses(entry, filter) && rectsIntersect(&entry->pos, area)) {
+			GxElemBufferPush_(out, entry->elem);
 		}
 	}
 
-	if (SDL_HasIntersection(&self->pos, &area)) {
-
-		for (GxElement* elem = GxListBegin(self->elements); elem != NULL; 
-				elem = GxListNext(self->elements)){
-		
-			if (self->type == sGraphical && GxElemGetWFlag_(elem) != gWCounter) {
-				GxElemSetWFlag_(elem, gWCounter);
-				callback(elem);
-			}
-			else if (self->type == sFixed && GxElemGetFFlag_(elem) != gFCounter) {
-				GxElemSetFFlag_(elem, gFCounter);
-				callback(elem);
-			}
-			else if (self->type == sDynamic && GxElemGetDFlag_(elem) != gDCounter) {
-				GxElemSetDFlag_(elem, gDCounter);
-				callback(elem);
-			}
-		}
+	if (node->children) {
+		for (Uint32 c = node->children; c < node->children + 4; c++) qtreeCollect(self, c, area, filter, out);
+	}
+}
 
-		if (self->children) {
-			for (Uint32 i = 0; i < GxArraySize(self->children); i++) {
-				GxQtree* child = GxArrayAt(self->children, i);
-				GxQtreeIterate_(child, area, callback, false);
-			}
-		}
+void GxQtreeCollect_(GxQtree* self, SDL_Rect area, GxElemBuffer* out) {
+	qtreeCollect(self, kRoot, &area, NULL, out);
+}
+
+void GxQtreeCollectFiltered_(GxQtree* self, SDL_Rect area, GxBroadphaseFilter filter, GxElemBuffer* out) {
+	qtreeCollect(self, kRoot, &area, &filter, out);
+}
+
+static void qtreeCollectSegment(const GxQtree* self, Uint32 index, SDL_Point from, SDL_Point to, 
+	const GxBroadphaseFilter* filter, GxElemBuffer* out) 
+{
+	const QtreeNode* node = &self->nodes[index];
+	SDL_Rect bounds = qtreeBounds(self, index);
+	int x1 = from.x, y1 = from.y, x2 = to.x, y2 = to.y;
+	if ((!self->loose || index != kRoot) && !SDL_IntersectRectAndLine(&bounds, &x1, &y1, &x2, &y2)) return;
+
+	for (int i = 0; i < node->size; i++) {
+		if (entryPasses(&node->entries[i], filter)) GxElemBufferPush_(out, node->entries[i].elem);
 	}
+
+	if (node->children) {
+		for (Uint32 c = node->children; c < node->children + 4; c++) qtreeCollectSegment(self, c, from, to, filter, out);
+	}
+}
+
+void GxQtreeCollectSegment_(GxQtree* self, SDL_Point from, SDL_Point to, 
+	GxBroadphaseFilter filter, GxElemBuffer* out) 
+{
+	//like GxQtreeCollectFiltered_, but only descends into the nodes the segment crosses
+	qtreeCollectSegment(self, kRoot, from, to, &filter, out);
 }
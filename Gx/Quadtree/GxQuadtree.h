@@ -1,17 +1,24 @@
 #ifndef GX_QUADTREE_H
 #define GX_QUADTREE_H
 #include "../Utilities/GxUtil.h"
+#include "../Broadphase/GxBroadphase.h"
 
 typedef struct GxQtree GxQtree;
 
-GxQtree* GxCreateQtree_(GxQtree* parent, SDL_Rect pos, const char* type);
+GxQtree* GxCreateQtree_(SDL_Rect pos, bool loose);
 void GxDestroyQtree_(GxQtree* self);
 SDL_Rect GxQtreeGetPosition_(GxQtree* self);
+GxBroadphaseStats GxQtreeGetStats_(GxQtree* self);
 void GxQtreeInsert_(GxQtree* self, GxElement* element);
 void GxQtreeRemove_(GxQtree* self, GxElement* element);
 void GxQtreeUpdate_(GxQtree* self, GxElement* element, SDL_Rect previous);
-void GxQtreeSubdivide_(GxQtree* self);
-void GxQtreeIterate_(GxQtree* self, SDL_Rect area, void(*callback)(GxElement*), bool begin);
+void GxQtreeRefresh_(GxQtree* self, GxElement* element);
+void GxQtreeRebalance_(GxQtree* self);
+void GxQtreeCollect_(GxQtree* self, SDL_Rect area, GxElemBuffer* out);
+void GxQtreeCollectFiltered_(GxQtree* self, SDL_Rect area, GxBroadphaseFilter filter, GxElemBuffer* out);
+void GxQtreeCollectSegment_(GxQtree* self, SDL_Point from, SDL_Point to, 
+	GxBroadphaseFilter filter, GxElemBuffer* out
+);
 
 #endif // !GX_QUADTREE_H
 
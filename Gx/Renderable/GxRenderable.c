@@ -97,9 +97,6 @@ typedef struct GxRenderable {
 	Color* color;
 	bool shouldUpdateLabel;
 	GxImage* label;
-
-	//...
-	Uint32 wflag;
 } GxRenderable;
 
 
@@ -174,7 +171,6 @@ GxRenderable* GxCreateRenderable_(GxElement* elem, const GxIni* ini) {
 
 	self->border.color = createColor(NULL);
 	GxElemSetBorder(elem, ini->border);
-	self->wflag = 0;
 	return self;
 }
 
@@ -444,28 +440,36 @@ void GxElemSetBorder(GxElement* self, const char* border) {
 	}
 }
 
-uint32_t GxElemGetWFlag_(GxElement* self) {
-	validateElem(self, false, true);
-	return self->renderable->wflag;
-}
 
-void GxElemSetWFlag_(GxElement* self, uint32_t value) {
-	validateElem(self, false, true);
-	self->renderable->wflag = value;
+//element render methods
+static inline int roundInterpolated(double value) {
+	return value >= 0.0 ? (int) (value + 0.5) : (int) (value - 0.5);
 }
 
+static inline SDL_Rect calcInterpolatedPos(GxElement* self) {
+	SDL_Rect pos = *self->pos;
+	double alpha = GxSceneGetAlpha(self->scene);
+
+	//on a fixed timestep, elements moved by the last tick are drawn between both states
+	if (alpha < 1.0 && self->lastTick == GxSceneGetTick_(self->scene)) {
+		pos.x = self->lastPos.x + roundInterpolated((pos.x - self->lastPos.x) * alpha);
+		pos.y = self->lastPos.y + roundInterpolated((pos.y - self->lastPos.y) * alpha);
+	}
+	return pos;
+}
 
-//element render methods
 static inline SDL_Rect calcAbsolutePos(GxElement* self) {
-	int y = GxGetWindowSize().h - (self->pos->y + self->pos->h);
-	return (SDL_Rect) { self->pos->x, y, self->pos->w, self->pos->h };
+	SDL_Rect pos = calcInterpolatedPos(self);
+	int y = GxGetWindowSize().h - (pos.y + pos.h);
+	return (SDL_Rect) { pos.x, y, pos.w, pos.h };
 }
 
 static inline SDL_Rect calcRelativePos(GxElement* self) {
-	const SDL_Rect* cpos = GxSceneGetCamera(self->scene)->pos;
-	int x = self->pos->x - cpos->x;
-	int y = (cpos->y + cpos->h) - (self->pos->y + self->pos->h);
-	return (SDL_Rect) { x, y, self->pos->w, self->pos->h };
+	SDL_Rect pos = calcInterpolatedPos(self);
+	SDL_Rect cpos = calcInterpolatedPos(GxSceneGetCamera(self->scene));
+	int x = pos.x - cpos.x;
+	int y = (cpos.y + cpos.h) - (pos.y + pos.h);
+	return (SDL_Rect) { x, y, pos.w, pos.h };
 }
 
 static inline void applyWidgetData(GxElement* self, SDL_Rect* pos, GxImage* image) {
@@ -41,9 +41,6 @@ int GxElemGetBorderSize(GxElement* self);
 void GxElemSetBorder(GxElement* self, const char* border);
 const SDL_Color* GxElemGetBorderColor(GxElement* self);
 
-uint32_t GxElemGetWFlag_(GxElement* self);
-void GxElemSetWFlag_(GxElement* self, uint32_t value);
-
 void GxElemRender_(GxElement* self);
 SDL_Rect GxGetElemPositionOnWindow(GxElement* self);
  SDL_Rect* GxElemCalcImagePos(GxElement* self, SDL_Rect* pos, GxImage* image);
@@ -3,14 +3,20 @@
 #include "../RigidBody/GxRigidBody.h"
 #include "../Physics/GxPhysics.h"
 #include "../Array/GxArray.h"
-#include "../List/GxList.h"
 #include "../Graphics/GxGraphics.h"
 #include "../Scene/GxScene.h"
+#include "../Snapshot/GxSnapshot.h"
 #include <string.h>
 #include <limits.h>
 
 
 
+//passes a body must rest before it falls asleep
+static const int kSleepPasses = 30;
+
+//contacts a body holds before its contact array moves to the heap
+enum { kInlineContacts = 4 };
+
 //... BODY AUXILIARY TYPES
 typedef enum BodyConstant {
 	Up,
@@ -20,17 +26,19 @@ typedef enum BodyConstant {
 } BodyConstant;
 
 typedef struct GxVelocity {
-	double x;
-	double y;
+	Sint32 x;
+	Sint32 y;
 } GxVelocity;
 
 typedef struct GxRigidBody {
 	int type;
 	Uint32 cmask;
+	Uint32 layer;
 	int preference;
 	GxVelocity velocity;
-	double elasticity;
-	double restitution;
+	GxVelocity remainder; //sub-pixel displacement not yet applied, in [0, GxFixedOne_)
+	Sint32 elasticity;
+	Sint32 restitution;
 	bool friction;
 	int maxgvel;
 
@@ -38,51 +46,103 @@ typedef struct GxRigidBody {
 	bool mcflag; // movement contact flag
 	bool movflag; // movement flag
 
-	//Flags used by GxPhysics trees to identify repeated elements
-	uint32_t fflag; // fixed tree flag
-	uint32_t dflag; // dynamic tree flag
+	//Stamp of the last carrier graph that reached the body
+	Uint32 carry;
 
 	//Flag used by Body to see if a element is on ground
 	int groundFlag;
 
-	//contacts
-	GxList* contacts;
-	GxArray* temp;
+	//distance travelled in the current physics pass, used to validate broadphase candidates
+	Uint32 pass;
+	int travel;
+
+	//sleeping bodies are skipped by GxPhysics until something wakes them
+	int idle;
+	bool sleeping;
+
+	//solid cells of a tilemap in grid mode, owned by the tilemap
+	const Uint8* tiles;
+	GxMatrix grid;
+
+	//contacts, kept in the inline array until they overflow
+	GxContact** contacts;
+	Uint32 ncontacts;
+	Uint32 ccontacts;
+	GxContact* inlineContacts[kInlineContacts];
+	GxArray* temp; //only created by GxElemGetContacts
 } GxRigidBody;
 
+//simulation state of a body in snapshots, the move flags are only set during a move
+typedef struct BodyState {
+	Uint32 cmask;
+	Uint32 layer;
+	int preference;
+	GxVelocity velocity;
+	GxVelocity remainder;
+	Sint32 elasticity;
+	Sint32 restitution;
+	bool friction;
+	int maxgvel;
+	int groundFlag;
+	Uint32 pass;
+	int travel;
+	int idle;
+	bool sleeping;
+} BodyState;
+
+static inline Sint32 toFixed(int value) {
+	return value * GxFixedOne_;
+}
+
+static inline Sint32 toFixedFromDouble(double value) {
+	return (Sint32) (value * GxFixedOne_ + (value >= 0.0 ? 0.5 : -0.5));
+}
+
+static inline int roundFixed(Sint32 value) {
+	return value >= 0 ? (value + GxFixedOne_ / 2) / GxFixedOne_ : -((GxFixedOne_ / 2 - value) / GxFixedOne_);
+}
+
 GxRigidBody* GxCreateRigidBody_(GxElement* elem, const GxIni* ini) {
 
-	if(ini->body != GxElemFixed && ini->body != GxElemDynamic){
+	if(ini->body != GxElemFixed && ini->body != GxElemDynamic && ini->body != GxElemSensor){
 		GxAssertInvalidArgument(ini->body == GxElemNone);
 		return NULL;
 	}
 
 	GxRigidBody* self = calloc(1, sizeof(GxRigidBody));
 	GxAssertAllocationFailure(self);
-	self->type = ini->body == GxElemFixed ? GxElemFixed : GxElemDynamic;
+	self->type = ini->body;
 	elem->body = self;
 	self->cmask = self->cmask == GxElemDynamic ? GxCmaskDynamic : GxCmaskFixed;	
-	self->velocity.x = ini->velocity.x;
-	self->velocity.y = ini->velocity.y;
-	self->elasticity = 0.0;
-	self->restitution = 1.0;
+	self->layer = ini->layer ? GxSceneGetLayer(elem->scene, ini->layer) : 0;
+	self->velocity.x = toFixed(ini->velocity.x);
+	self->velocity.y = toFixed(ini->velocity.y);
+	self->remainder = (GxVelocity) { 0, 0 };
+	self->elasticity = 0;
+	self->restitution = GxFixedOne_;
 	self->friction = ini->friction ? ini->friction : false;
 	self->preference = self->type == GxElemDynamic ? 1 : INT_MAX;
 	self->maxgvel = self->type == GxElemDynamic? -20 : 0;		
 	self->mcflag = false;
 	self->movflag = false;
-	self->dflag = 0;
-	self->fflag = 0;
-	self->contacts = GxCreateList();
-	self->temp = GxCreateArray();
+	self->carry = 0;
+	self->contacts = self->inlineContacts;
+	self->ncontacts = 0;
+	self->ccontacts = kInlineContacts;
+	self->temp = NULL;
 	self->groundFlag = 0;
+	self->pass = 0;
+	self->travel = 0;
+	self->idle = 0;
+	self->sleeping = false;
+	self->tiles = NULL;
 	return self;
 }
 
 void GxDestroyRigidBody_(GxRigidBody* self) {
 	if (self) {
-		GxDestroyArray(self->temp);
-		GxDestroyList(self->contacts);
+		if (self->temp) GxDestroyArray(self->temp);
+		if (self->contacts != self->inlineContacts) free(self->contacts);
 		free(self);
 	}
 }
@@ -97,6 +157,11 @@ bool GxElemHasFixedBody(GxElement* self) {
 	return self->body && self->body->type == GxElemFixed;
 }
 
+bool GxElemIsSensor(GxElement* self) {
+	validateElem(self, false, false);
+	return self->body && self->body->type == GxElemSensor;
+}
+
 bool GxElemIsOnGround(GxElement* self) {
 	validateElem(self, true, false);
 	return self->body->groundFlag;
@@ -107,9 +172,48 @@ Uint32 GxElemGetCmask(GxElement* self) {
 	return self->body->cmask;
 }
 
+static inline void setCmask(GxElement* self, Uint32 mask) {
+	//the physics trees cache the collision filter
+	if (self->body->cmask == mask) return;
+	self->body->cmask = mask;
+	GxPhysics* physics = GxSceneGetPhysics(self->scene);
+	if (physics && !GxSceneHasStatus(self->scene, GxStatusUnloading)) GxPhysicsRefreshElement_(physics, self);
+}
+
 void GxElemSetCmask(GxElement* self, Uint32 mask) {
 	validateElem(self, true, false);
-	self->body->cmask = mask;
+	setCmask(self, mask);
+}
+
+const char* GxElemGetLayer(GxElement* self) {
+	validateElem(self, true, false);
+	return GxSceneGetLayerName(self->scene, self->body->layer);
+}
+
+void GxElemSetLayer(GxElement* self, const char* layer) {
+	validateElem(self, true, false);
+	GxAssertNullPointer(layer);
+	Uint32 index = GxSceneGetLayer(self->scene, layer);
+	if (self->body->layer == index) return;
+	self->body->layer = index;
+	GxPhysics* physics = GxSceneGetPhysics(self->scene);
+	if (physics && !GxSceneHasStatus(self->scene, GxStatusUnloading)) GxPhysicsRefreshElement_(physics, self);
+}
+
+Uint32 GxElemGetLayer_(GxElement* self) {
+	return self->body->layer;
+}
+
+const Uint8* GxElemGetTileGrid_(GxElement* self, GxMatrix* matrix) {
+	if (matrix) *matrix = self->body->grid;
+	return self->body->tiles;
+}
+
+void GxElemSetTileGrid_(GxElement* self, GxMatrix matrix, const Uint8* tiles) {
+	validateElem(self, true, false);
+	GxAssertInvalidOperation(self->body->type == GxElemFixed);
+	self->body->grid = matrix;
+	self->body->tiles = tiles;
 }
 
 int GxElemGetPreference(GxElement* self) {
@@ -134,72 +238,86 @@ void GxElemSetFriction(GxElement* self, bool value) {
 
 GxVector GxElemGetVelocity(GxElement* self) {
 	validateElem(self, true, false);
-	const GxVelocity* svel = &self->body->velocity;
-	GxVector vel = {
-		.x = svel->x > 0 ? (int) (svel->x + 0.5) : (int)(svel->x - 0.5),
-		.y = svel->y > 0 ? (int) (svel->y + 0.5) : (int)(svel->y - 0.5)
-	};
-	return vel;
+	return (GxVector) { roundFixed(self->body->velocity.x), roundFixed(self->body->velocity.y) };
 }
 
 
 void GxElemSetVelocity(GxElement* self, GxVector velocity){
 	validateElem(self, true, false);	
-	self->body->velocity.x = velocity.x;
-	self->body->velocity.y = velocity.y;
+	self->body->velocity.x = toFixed(velocity.x);
+	self->body->velocity.y = toFixed(velocity.y);
+	if (velocity.x || velocity.y) GxElemWake(self);
 }
 
 int GxElemGetVely(GxElement* self) {
 	validateElem(self, true, false);
-	return self->body->velocity.y > 0 ?
-		(int) (self->body->velocity.y + 0.5) : (int) (self->body->velocity.y - 0.5);
+	return roundFixed(self->body->velocity.y);
 }
 
 void GxElemSetVely(GxElement* self, int y) {
 	validateElem(self, true, false);
-	self->body->velocity.y = y;
+	self->body->velocity.y = toFixed(y);
+	if (y) GxElemWake(self);
 }
 
 int GxElemGetVelx(GxElement* self) {
 	validateElem(self, true, false);
-	return self->body->velocity.x > 0 ?
-		(int) (self->body->velocity.x + 0.5) : (int) (self->body->velocity.x - 0.5);
+	return roundFixed(self->body->velocity.x);
 }
 
 void GxElemSetVelx(GxElement* self, int x) {
 	validateElem(self, true, false);
-	self->body->velocity.x = x;}
+	self->body->velocity.x = toFixed(x);
+	if (x) GxElemWake(self);
+}
 
 void GxElemAccelerate(GxElement* self, double x, double y) {
 	validateElem(self, true, false);
-	self->body->velocity.x += x;
-	self->body->velocity.y += y;
+	Sint32 fx = toFixedFromDouble(x), fy = toFixedFromDouble(y);
+	self->body->velocity.x += fx;
+	self->body->velocity.y += fy;
+	if (fx || fy) GxElemWake(self);
 }
 
 bool GxElemIsMoving(GxElement* self) {
 	validateElem(self, true, false);
-	GxVector velocity = GxElemGetVelocity(self);
-	return (velocity.x || velocity.y);
+	return (self->body->velocity.x || self->body->velocity.y);
+}
+
+bool GxElemIsSleeping(GxElement* self) {
+	validateElem(self, true, false);
+	return self->body->sleeping;
+}
+
+void GxElemWake(GxElement* self) {
+	validateElem(self, true, false);
+	self->body->sleeping = false;
+	self->body->idle = 0;
 }
 
 double GxElemGetElasticity(GxElement* self) {
 	validateElem(self, true, false);
-	return self->body->elasticity;
+	return (double) self->body->elasticity / GxFixedOne_;
 }
 
 void GxElemSetElasticity(GxElement* self, double elasticity) {
 	validateElem(self, true, false);
-	self->body->elasticity = elasticity;
+	self->body->elasticity = toFixedFromDouble(elasticity);
 }
 
 double GxElemGetRestitution(GxElement* self) {
 	validateElem(self, true, false);
-	return self->body->restitution;
+	return (double) self->body->restitution / GxFixedOne_;
 }
 
 void GxElemSetRestitution(GxElement* self, double restitution) {
 	validateElem(self, true, false);
-	self->body->restitution = restitution;
+	self->body->restitution = toFixedFromDouble(restitution);
+}
+
+Sint32 GxElemGetRestitution_(GxElement* self) {
+	validateElem(self, true, false);
+	return self->body->restitution;
 }
 
 int GxElemGetMaxgvel(GxElement* self) {
@@ -213,31 +331,76 @@ void GxElemSetMaxgvel(GxElement* self, int value) {
 	if (self->body->maxgvel > 0) self->body->maxgvel *= -1;
 }
 
+static inline bool bodyReserveContacts(GxRigidBody* body, Uint32 count) {
+	//the array moves to the heap once the inline one is full
+	if (count <= body->ccontacts) return false;
+	while (body->ccontacts < count) body->ccontacts *= 2;
+	if (body->contacts == body->inlineContacts) {
+		body->contacts = malloc(body->ccontacts * sizeof(GxContact*));
+		GxAssertAllocationFailure(body->contacts);
+		memcpy(body->contacts, body->inlineContacts, body->ncontacts * sizeof(GxContact*));
+	}
+	else {
+		body->contacts = realloc(body->contacts, body->ccontacts * sizeof(GxContact*));
+		GxAssertAllocationFailure(body->contacts);
+	}
+	return true;
+}
+
 GxArray* GxElemGetContacts(GxElement* self, int direction) {
 	validateElem(self, true, false);
 
+	if (!self->body->temp) self->body->temp = GxCreateArray();
 	GxArrayClean(self->body->temp);
-
-	for(GxContact* contact = GxListBegin(self->body->contacts); contact != NULL;
-		contact = GxListNext(self->body->contacts))
+	Uint32 cursor = 0;
+	for (GxContact* contact = GxElemNextContact(self, direction, &cursor); contact != NULL;
+		contact = GxElemNextContact(self, direction, &cursor))
 	{
-		if (GxContactHasDirection(contact, direction)) {
-			GxArrayPush(self->body->temp, contact, NULL);
-		}
+		GxArrayPush(self->body->temp, contact, NULL);
 	}
 	return self->body->temp;
 }
 
-GxList* GxElemGetContactList_(GxElement* self) {
+GxContact* GxElemNextContact(GxElement* self, int direction, Uint32* cursor) {
+	validateElem(self, true, false);
+	GxRigidBody* body = self->body;
+	while (*cursor < body->ncontacts) {
+		GxContact* contact = body->contacts[(*cursor)++];
+		if (GxContactHasDirection(contact, direction)) return contact;
+	}
+	return NULL;
+}
+
+GxContact* const* GxElemGetContactArray_(GxElement* self, Uint32* count) {
 	validateElem(self, true, false);
+	*count = self->body->ncontacts;
 	return self->body->contacts;
 }
 
+bool GxElemSetContacts_(GxElement* self, GxContact* const* contacts, Uint32 count) {
+	//replaces the contacts as they are, the ground flag is restored with the body state
+	validateElem(self, true, false);
+	GxRigidBody* body = self->body;
+	bool grown = bodyReserveContacts(body, count);
+	memcpy(body->contacts, contacts, count * sizeof(GxContact*));
+	body->ncontacts = count;
+	return grown;
+}
+
 void elemRemoveContact_(GxElement* self, GxContact* contact) {
 	validateElem(self, true, false);
 
-	//first remove contact
-	GxListRemove(self->body->contacts, contact);
+	//first remove contact, keeping the order the contacts were made in,
+	//losing a neighbour may leave the body unsupported
+	GxRigidBody* body = self->body;
+	for (Uint32 i = 0; i < body->ncontacts; i++) {
+		if (body->contacts[i] == contact) {
+			memmove(body->contacts + i, body->contacts + i + 1, (body->ncontacts - i - 1) * sizeof(GxContact*));
+			body->ncontacts--;
+			break;
+		}
+	}
+	GxElemWake(self);
 
 	//then change ground flag if contact is down and not prevented
 	if (GxContactIsElemDownContact(contact, self) && !GxContactIsPrevented(contact)){
@@ -246,35 +409,30 @@ void elemRemoveContact_(GxElement* self, GxContact* contact) {
 }
 
 
-void elemAddContact_(GxElement* self, GxContact* contact) {
+bool elemAddContact_(GxElement* self, GxContact* contact) {
 	validateElem(self, true, false);
 
-	//fist add contact
-	GxListPush(self->body->contacts, contact, NULL);
+	//fist add contact, telling physics when the array had to grow
+	GxRigidBody* body = self->body;
+	bool grown = bodyReserveContacts(body, body->ncontacts + 1);
+	body->contacts[body->ncontacts++] = contact;
+	self->body->idle = 0;
 
 	//then change ground flag if contact is down and not prevented
 	if (GxContactIsElemDownContact(contact, self) && !GxContactIsPrevented(contact)){
 		self->body->groundFlag++;
 	}	
+	return grown;
 }
 
-uint32_t GxElemGetDFlag_(GxElement* self) {
+Uint32 GxElemGetCarryFlag_(GxElement* self) {
 	validateElem(self, true, false);
-	return self->body->dflag;
+	return self->body->carry;
 }
 
-void GxElemSetDFlag_(GxElement* self, uint32_t value) {
-	validateElem(self, true, false);
-	self->body->dflag = value;
-}
-uint32_t GxElemGetFFlag_(GxElement* self) {
+void GxElemSetCarryFlag_(GxElement* self, Uint32 value) {
 	validateElem(self, true, false);
-	return self->body->fflag;
-}
-
-void GxElemSetFFlag_(GxElement* self, uint32_t value) {
-	validateElem(self, true, false);
-	self->body->fflag = value;
+	self->body->carry = value;
 }
 
 bool GxElemGetMcFlag_(GxElement* self) {
@@ -302,18 +460,17 @@ GxVector GxElemMove(GxElement* self, GxVector vector, bool force) {
 	if (vector.x == 0 && vector.y == 0) {
 		return vector;
 	}
-	if (self->body) {
-		Uint32 mask = self->body->cmask;
+	if (self->body && self->body->type != GxElemSensor) {
 		GxVelocity velocity = self->body->velocity;
+		GxVelocity remainder = self->body->remainder;
 		int gvel = self->body->maxgvel;
-		self->body->cmask = force ? 1u << 31 : mask;
-		self->body->velocity.x = vector.x;
-		self->body->velocity.y = vector.y;
+		self->body->velocity.x = toFixed(vector.x);
+		self->body->velocity.y = toFixed(vector.y);
+		self->body->remainder = (GxVelocity) { 0, 0 };
 		self->body->maxgvel = 0;
-		GxVector GxPhysicsMoveCalledByElem_(GxPhysics * self, GxElement * element);
-		vector = GxPhysicsMoveCalledByElem_(GxSceneGetPhysics(self->scene), self);
-		self->body->cmask = mask;
+		vector = GxPhysicsMoveCalledByElem_(GxSceneGetPhysics(self->scene), self, force);
 		self->body->velocity = velocity;
+		self->body->remainder = remainder;
 		self->body->maxgvel = gvel;
 	}
 	else {
@@ -329,19 +486,140 @@ void GxElemMoveTo(GxElement* self, GxPoint pos, bool force) {
 
 void GxElemExecuteMove_(GxElement* self, GxVector vector) {
 	validateElem(self, false, false);
+	if (self->body) GxElemWake(self);
 	SDL_Rect previousPos = *self->pos;
+	Uint32 tick = GxSceneGetTick_(self->scene);
+	if (self->lastTick != tick) {
+		self->lastTick = tick;
+		self->lastPos = (SDL_Point) { previousPos.x, previousPos.y };
+	}
 	self->pos->x += vector.x;
 	self->pos->y += vector.y;
 	GxGraphicsUpdatePosition_(GxSceneGetGraphics(self->scene), self, previousPos);
 	GxPhysicsUpdateElementPosition_(GxSceneGetPhysics(self->scene), self, previousPos);
 }
 
-void GxElemApplyHozElasticity_(GxElement* self, double res) {
-	self->body->velocity.x *= -(self->body->elasticity * res);
+static inline Sint32 fallVelocity(const GxRigidBody* body, Sint32 velocity, Sint32 acceleration) {
+	//a far body gains several ticks of gravity at once, it still stops at the terminal velocity
+	Sint32 terminal = toFixed(body->maxgvel);
+	velocity += acceleration;
+	return velocity < terminal ? terminal : velocity;
+}
+
+void GxElemApplyGravity_(GxElement* self, Sint32 acceleration) {
+	GxRigidBody* body = self->body;
+	if (body->maxgvel && toFixed(body->maxgvel) < body->velocity.y && !body->groundFlag) {
+		body->velocity.y = fallVelocity(body, body->velocity.y, acceleration);
+	}
+}
+
+static inline Sint32 scaleStep(Sint32 velocity, int stride, int tickRate) {
+	return (Sint32) ((Sint64) velocity * stride * GxReferenceTickRate_ / tickRate);
+}
+
+GxVector GxElemTakeStep_(GxElement* self, int stride, int tickRate) {
+	//the remainder keeps the fraction of a pixel the body could not move yet,
+	//stride > 1 covers several ticks at once
+	GxRigidBody* body = self->body;
+	Sint32 x = body->remainder.x + scaleStep(body->velocity.x, stride, tickRate);
+	Sint32 y = body->remainder.y + scaleStep(body->velocity.y, stride, tickRate);
+	body->remainder.x = x & (GxFixedOne_ - 1);
+	body->remainder.y = y & (GxFixedOne_ - 1);
+	return (GxVector) { (x - body->remainder.x) / GxFixedOne_, (y - body->remainder.y) / GxFixedOne_ };
 }
 
-void GxElemApplyVetElasticity_(GxElement* self, double res) {
-	self->body->velocity.y *= -(self->body->elasticity * res);
+GxVector GxElemPeekStep_(GxElement* self, Sint32 acceleration, int stride, int tickRate) {
+	//same displacement GxElemApplyGravity_ and GxElemTakeStep_ would produce, without changing the body
+	const GxRigidBody* body = self->body;
+	Sint32 vely = body->velocity.y;
+	if (body->maxgvel && toFixed(body->maxgvel) < vely && !body->groundFlag) vely = fallVelocity(body, vely, acceleration);
+	Sint32 x = body->remainder.x + scaleStep(body->velocity.x, stride, tickRate);
+	Sint32 y = body->remainder.y + scaleStep(vely, stride, tickRate);
+	return (GxVector) { (x - (x & (GxFixedOne_ - 1))) / GxFixedOne_, (y - (y & (GxFixedOne_ - 1))) / GxFixedOne_ };
 }
 
+int GxElemAddTravel_(GxElement* self, Uint32 pass, int distance) {
+	if (self->body->pass != pass) {
+		self->body->pass = pass;
+		self->body->travel = 0;
+	}
+	self->body->travel += distance;
+	return self->body->travel;
+}
 
+void GxElemUpdateRest_(GxElement* self, bool gravity) {
+	//a still body that is supported, or floats without gravity, is at rest
+	GxRigidBody* body = self->body;
+	bool still = !body->velocity.x && !body->velocity.y && (body->groundFlag || !gravity);
+	body->idle = still ? body->idle + 1 : 0;
+	if (body->idle >= kSleepPasses) body->sleeping = true;
+}
+
+static inline Sint32 applyElasticity(Sint32 velocity, Sint32 elasticity, Sint32 res) {
+	//truncates towards zero, so a bouncing body always comes to rest
+	int64_t product = (int64_t) velocity * elasticity * res;
+	return (Sint32) -(product / (GxFixedOne_ * GxFixedOne_));
+}
+
+void GxElemApplyHozElasticity_(GxElement* self, Sint32 res) {
+	self->body->velocity.x = applyElasticity(self->body->velocity.x, self->body->elasticity, res);
+	self->body->remainder.x = 0;
+}
+
+void GxElemApplyVetElasticity_(GxElement* self, Sint32 res) {
+	self->body->velocity.y = applyElasticity(self->body->velocity.y, self->body->elasticity, res);
+	self->body->remainder.y = 0;
+}
+
+void GxElemSaveBody_(GxElement* self, GxSnapshot* snapshot) {
+	validateElem(self, true, false);
+	GxRigidBody* body = self->body;
+	BodyState state = {
+		.cmask = body->cmask,
+		.layer = body->layer,
+		.preference = body->preference,
+		.velocity = body->velocity,
+		.remainder = body->remainder,
+		.elasticity = body->elasticity,
+		.restitution = body->restitution,
+		.friction = body->friction,
+		.maxgvel = body->maxgvel,
+		.groundFlag = body->groundFlag,
+		.pass = body->pass,
+		.travel = body->travel,
+		.idle = body->idle,
+		.sleeping = body->sleeping,
+	};
+	GxSnapshotWrite_(snapshot, &state, sizeof(BodyState));
+
+	//the solid cells of a grid can change while the game runs
+	if (body->tiles) GxSnapshotWrite_(snapshot, body->tiles, (size_t) (body->grid.nr * body->grid.nc));
+}
+
+bool GxElemRestoreBody_(GxElement* self, const GxSnapshot* snapshot, size_t* offset) {
+	//written in place, the setters would mark the restored sensor state again. Returns
+	//whether the collision filter changed, so the caller refreshes the trees
+	validateElem(self, true, false);
+	GxRigidBody* body = self->body;
+	BodyState state;
+	GxSnapshotRead_(snapshot, offset, &state, sizeof(BodyState));
+	bool filtered = body->cmask != state.cmask || body->layer != state.layer;
+	body->cmask = state.cmask;
+	body->layer = state.layer;
+	body->preference = state.preference;
+	body->velocity = state.velocity;
+	body->remainder = state.remainder;
+	body->elasticity = state.elasticity;
+	body->restitution = state.restitution;
+	body->friction = state.friction;
+	body->maxgvel = state.maxgvel;
+	body->groundFlag = state.groundFlag;
+	body->pass = state.pass;
+	body->travel = state.travel;
+	body->idle = state.idle;
+	body->sleeping = state.sleeping;
+	if (body->tiles) {
+		GxSnapshotRead_(snapshot, offset, (Uint8*) body->tiles, (size_t) (body->grid.nr * body->grid.nc));
+	}
+	return filtered;
+}
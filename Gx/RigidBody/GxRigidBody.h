@@ -3,10 +3,18 @@
 #include "../Utilities/GxUtil.h"
 #include "../Element/GxElement.h"
 
+//velocities, elasticity and restitution are stored in 24.8 fixed point
+enum { GxFixedShift_ = 8, GxFixedOne_ = 1 << GxFixedShift_ };
+
+//velocities are pixels per tick at this rate, other tick rates scale the steps they take
+enum { GxReferenceTickRate_ = 60 };
+
 bool GxElemIsOnGround(GxElement* self);
 
 Uint32 GxElemGetCmask(GxElement* self);
 void GxElemSetCmask(GxElement* self, Uint32 mask);
+const char* GxElemGetLayer(GxElement* self);
+void GxElemSetLayer(GxElement* self, const char* layer);
 
 int GxElemGetPreference(GxElement* self);
 void GxElemSetPreference(GxElement* self, int value);
@@ -26,6 +34,8 @@ void GxElemSetVelx(GxElement* self, int vel);
 void GxElemAccelerate(GxElement* self, double x, double y);
 
 bool GxElemIsMoving(GxElement* self);
+bool GxElemIsSleeping(GxElement* self);
+void GxElemWake(GxElement* self);
 
 double GxElemGetElasticity(GxElement* self);
 void GxElemSetElasticity(GxElement* self, double elasticity);
@@ -37,16 +47,19 @@ int GxElemGetMaxgvel(GxElement* self);
 void GxElemSetMaxgvel(GxElement* self, int value);
 
 GxArray* GxElemGetContacts(GxElement* self, int types);
-GxList* GxElemGetContactList_(GxElement* self);
-
-void elemAddContact_(GxElement * self, GxContact * contact);
+//iterates the contacts in place, the cursor starts at zero and the contacts must not change meanwhile
+GxContact* GxElemNextContact(GxElement* self, int types, Uint32* cursor);
+GxContact* const* GxElemGetContactArray_(GxElement* self, Uint32* count);
+bool GxElemSetContacts_(GxElement* self, GxContact* const* contacts, Uint32 count);
+Uint32 GxElemGetLayer_(GxElement* self);
+const Uint8* GxElemGetTileGrid_(GxElement* self, GxMatrix* matrix);
+void GxElemSetTileGrid_(GxElement* self, GxMatrix matrix, const Uint8* tiles);
+
+bool elemAddContact_(GxElement * self, GxContact * contact);
 void elemRemoveContact_(GxElement * self, GxContact * contact);
 
-uint32_t GxElemGetDFlag_(GxElement* self);
-void GxElemSetDFlag_(GxElement* self, uint32_t value);
-
-uint32_t GxElemGetFFlag_(GxElement* self);
-void GxElemSetFFlag_(GxElement* self, uint32_t value);
+Uint32 GxElemGetCarryFlag_(GxElement* self);
+void GxElemSetCarryFlag_(GxElement* self, Uint32 value);
 
 bool GxElemGetMcFlag_(GxElement* self);
 void GxElemSetMcFlag_(GxElement* self, bool value);
@@ -58,8 +71,17 @@ GxVector GxElemMove(GxElement* self, GxVector vector, bool force);
 void GxElemMoveTo(GxElement* self, GxPoint pos, bool force);
 void GxElemExecuteMove_(GxElement* self, GxVector vector);
 
-void GxElemApplyHozElasticity_(GxElement* self, double res);
-void GxElemApplyVetElasticity_(GxElement* self, double res);
+Sint32 GxElemGetRestitution_(GxElement* self);
+void GxElemApplyGravity_(GxElement* self, Sint32 acceleration);
+GxVector GxElemTakeStep_(GxElement* self, int stride, int tickRate);
+GxVector GxElemPeekStep_(GxElement* self, Sint32 acceleration, int stride, int tickRate);
+int GxElemAddTravel_(GxElement* self, Uint32 pass, int distance);
+void GxElemUpdateRest_(GxElement* self, bool gravity);
+void GxElemApplyHozElasticity_(GxElement* self, Sint32 res);
+void GxElemApplyVetElasticity_(GxElement* self, Sint32 res);
+
+void GxElemSaveBody_(GxElement* self, GxSnapshot* snapshot);
+bool GxElemRestoreBody_(GxElement* self, const GxSnapshot* snapshot, size_t* offset);
 
 
 #endif // !RIGID_BODY_H
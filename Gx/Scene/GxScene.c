@@ -11,6 +11,7 @@
 #include "../Folder/GxFolder.h"
 #include "../Button/GxButton.h"
 #include "../Event/GxEvent.h"
+#include "../Snapshot/GxSnapshot.h"
 #include <string.h>
 
 
@@ -25,6 +26,30 @@ typedef struct GxScene {
 	GxPhysics* physics;	
 	int gravity;
 	GxElement* camera;
+
+	//fixed timestep (tickRate == 0 runs a single tick per frame)
+	int tickRate;
+	int maxTicks;
+	Uint32 tick;
+	Uint64 lastCounter;
+	double accumulator;
+	double alpha;
+
+	//simulation policy: bodies inside the area run every tick, the others every farRate ticks
+	SDL_Rect simArea;
+	bool hasSimArea; //otherwise the area follows the camera
+	int simMargin;
+	int farRate; //0 freezes the bodies outside the area
+	bool batchContacts; //contact begin and end run after the physics pass
+	bool looseTrees; //the spatial trees store each element in a single node
+	int broadphase; //quadtrees or hashed grids, fixed when the scene loads
+	int cellSize;
+
+	//collision layers, each row holds the layers the movers of a layer collide with
+	char* layers[GxLayerMax];
+	Uint32 lmatrix[GxLayerMax];
+	int nlayers;
+
 	GxArray* elements;	
 	GxArray* folders;
 	GxList* listeners[GxEventTotalHandlers];
@@ -47,6 +72,20 @@ typedef struct Listener {
 	GxHandler handler;	
 }Listener;
 
+//head of a snapshot, followed by the timers, the physics state and every live element
+typedef struct SnapshotHeader {
+	GxScene* scene;
+	Uint32 tick;
+	Uint32 nelements; //ids are never reused, so equal sizes mean no element was created since
+	Uint32 nlive;
+	Uint32 ntimers;
+} SnapshotHeader;
+
+static const int kDefaultTickRate = 60;
+static const int kDefaultMaxTicks = 5;
+static const int kDefaultSimMargin = 64;
+static const int kDefaultCellSize = 64;
+
 //constructor and destructor
 GxScene* GxCreateScene(const GxIni* ini) {
 	
@@ -72,6 +111,23 @@ GxScene* GxCreateScene(const GxIni* ini) {
 	self->size.h = ini->size.h > windowSize.h ? ini->size.h : windowSize.h;
 	self->status = GxStatusNone;
 	self->gravity = ini->gravity > 0 ? -ini->gravity : ini->gravity;	
+	self->tickRate = ini->tickRate > 0 ? ini->tickRate : 0;
+	self->maxTicks = ini->maxTicks > 0 ? ini->maxTicks : kDefaultMaxTicks;
+	self->alpha = 1.0;
+	if (ini->simArea) {
+		self->simArea = *ini->simArea;
+		self->hasSimArea = true;
+	}
+	//a zeroed ini keeps the default margin, a negative one asks for no margin
+	self->simMargin = ini->simMargin > 0 ? ini->simMargin : ini->simMargin < 0 ? 0 : kDefaultSimMargin;
+	self->farRate = ini->farRate > 0 ? ini->farRate : 0;
+	self->batchContacts = ini->batchContacts;
+	self->looseTrees = ini->looseTrees;
+	self->broadphase = ini->broadphase == GxBroadphaseGrid ? GxBroadphaseGrid : GxBroadphaseQuadtree;
+	self->cellSize = ini->cellSize > 0 ? ini->cellSize : kDefaultCellSize;
+	self->layers[0] = GmCreateString(GxLayerDefault);
+	self->nlayers = 1;
+	for (int i = 0; i < GxLayerMax; i++) self->lmatrix[i] = ~0u;
 
 	//set callback module
 	self->target = ini->target ? ini->target : self;
@@ -143,6 +199,7 @@ void GxDestroyScene_(GxScene* self) {
 		}
 		free(self->handlers);
 		free(self->name);
+		for (int i = 0; i < self->nlayers; i++) free(self->layers[i]);
 		self->hash = 0;
 		free(self);
 	}
@@ -222,6 +279,135 @@ bool GxSceneHasGravity(GxScene* self) {
 	return self->gravity;
 }
 
+int GxSceneGetTickRate(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	return self->tickRate ? self->tickRate : kDefaultTickRate;
+}
+
+double GxSceneGetAlpha(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	return self->alpha;
+}
+
+Uint32 GxSceneGetTick_(GxScene* self) {
+	return self->tick;
+}
+
+SDL_Rect GxSceneGetSimulationArea(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	if (self->hasSimArea) return self->simArea;
+	SDL_Rect area = *GxElemGetPosition(self->camera);
+	area.x -= self->simMargin;
+	area.y -= self->simMargin;
+	area.w += 2 * self->simMargin;
+	area.h += 2 * self->simMargin;
+	return area;
+}
+
+int GxSceneGetSimulationMargin(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	return self->simMargin;
+}
+
+int GxSceneGetFarRate(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	return self->farRate;
+}
+
+bool GxSceneIsBatchingContacts(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	return self->batchContacts;
+}
+
+bool GxSceneHasLooseTrees(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	return self->looseTrees;
+}
+
+int GxSceneGetBroadphase(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	return self->broadphase;
+}
+
+int GxSceneGetCellSize(GxScene* self) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	return self->cellSize;
+}
+
+bool GxSceneRaycast(GxScene* self, SDL_Point from, SDL_Point to, Uint32 cmask, GxRayHit* hit) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxAssertInvalidOperation(self->physics);
+	return GxPhysicsRaycastFirst_(self->physics, from, to, cmask, hit);
+}
+
+int GxSceneRaycastAll(GxScene* self, SDL_Point from, SDL_Point to, Uint32 cmask, 
+	GxRayHit* hits, int capacity) 
+{
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxAssertInvalidOperation(self->physics);
+	return GxPhysicsRaycast_(self->physics, from, to, cmask, hits, capacity);
+}
+
+int GxSceneQueryRect(GxScene* self, SDL_Rect area, Uint32 cmask, GxElement** elems, int capacity) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxAssertInvalidOperation(self->physics);
+	return GxPhysicsQueryRect_(self->physics, area, cmask, elems, capacity);
+}
+
+int GxSceneQueryPoint(GxScene* self, SDL_Point point, Uint32 cmask, GxElement** elems, int capacity) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxAssertInvalidOperation(self->physics);
+	return GxPhysicsQueryRect_(self->physics, (SDL_Rect) { point.x, point.y, 1, 1 }, cmask, elems, capacity);
+}
+
+static inline int sceneFindLayer(GxScene* self, const char* name) {
+	GxAssertNullPointer(name);
+	for (int i = 0; i < self->nlayers; i++) {
+		if (strcmp(self->layers[i], name) == 0) return i;
+	}
+	return -1;
+}
+
+Uint32 GxSceneGetLayer(GxScene* self, const char* name) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	int index = sceneFindLayer(self, name);
+	if (index >= 0) return index;
+	//layers are registered on first use
+	GxAssertInvalidOperation(self->nlayers < GxLayerMax);
+	self->layers[self->nlayers] = GmCreateString(name);
+	return self->nlayers++;
+}
+
+const char* GxSceneGetLayerName(GxScene* self, Uint32 layer) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxAssertInvalidArgument(layer < (Uint32) self->nlayers);
+	return self->layers[layer];
+}
+
+void GxSceneSetLayerCollision(GxScene* self, const char* layer, const char* other, bool collide) {
+	//one way: the movers of layer collide, or not, with the elements of other. Both layers
+	//must exist already, created by an element or GxSceneGetLayer, so a typo can't take a slot
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	int row = sceneFindLayer(self, layer);
+	int column = sceneFindLayer(self, other);
+	GxAssertInvalidArgument(row >= 0 && column >= 0);
+	if (collide) self->lmatrix[row] |= 1u << column;
+	else self->lmatrix[row] &= ~(1u << column);
+}
+
+bool GxSceneLayersCollide(GxScene* self, const char* layer, const char* other) {
+	//a query never registers layers, so an unknown name is a mistake and not a new slot
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	int row = sceneFindLayer(self, layer);
+	int column = sceneFindLayer(self, other);
+	GxAssertInvalidArgument(row >= 0 && column >= 0);
+	return self->lmatrix[row] & (1u << column);
+}
+
+Uint32 GxSceneGetLayerMask_(GxScene* self, Uint32 layer) {
+	return self->lmatrix[layer];
+}
+
 void GxScenePause(GxScene* self) {
 	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
 	if (self->status == GxStatusRunning) {
@@ -241,6 +427,29 @@ void GxSceneSetGravity(GxScene* self, int gravity) {
 	self->gravity = gravity > 0 ? -gravity : gravity;
 }
 
+void GxSceneSetSimulationArea(GxScene* self, const SDL_Rect* area) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	self->hasSimArea = area != NULL;
+	if (area) self->simArea = *area;
+}
+
+void GxSceneSetSimulationMargin(GxScene* self, int margin) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxAssertInvalidArgument(margin >= 0);
+	self->simMargin = margin;
+}
+
+void GxSceneSetFarRate(GxScene* self, int rate) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxAssertInvalidArgument(rate >= 0);
+	self->farRate = rate;
+}
+
+void GxSceneSetBatchContacts(GxScene* self, bool value) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	self->batchContacts = value;
+}
+
 Uint32 GxSceneGetPercLoaded(GxScene* self) {
 	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
 	
@@ -278,20 +487,94 @@ void GxSceneSetTimeout(GxScene* self, int interval, GxHandler callback, void* ta
 	Timer* timer = malloc(sizeof(Timer));
 	GxAssertAllocationFailure(timer);
 	timer->callback = callback;
-	timer->counter = interval;
+	//the interval counts ticks at the reference rate
+	timer->counter = interval * GxSceneGetTickRate(self) / GxReferenceTickRate_;
 	timer->target = target;	
 	GxListPush(self->listeners[GxEventTimeout], timer, free);
 }
 
-Uint32 GxSceneAddElement_(GxScene* self, GxElement* elem) {
+void GxSceneRebalance(GxScene* self) {
+	//the trees merge sparse nodes as elements leave them, this also merges what is
+	//merely under a leaf's capacity, so it suits the quiet frames of a game
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxGraphicsRebalance_(self->graphics);
+	GxPhysicsRebalance_(self->physics);
+}
+
+void GxSceneSaveSnapshot(GxScene* self, GxSnapshot* snapshot) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	GxList* timers = self->listeners[GxEventTimeout];
+	SnapshotHeader header = { self, self->tick, GxArraySize(self->elements), 0, (Uint32) GxListSize(timers) };
+	for (Uint32 i = 0; i < header.nelements; i++) {
+		if (GxArrayAt(self->elements, i)) header.nlive++;
+	}
+
+	snapshot->size = 0;
+	GxSnapshotWrite_(snapshot, &header, sizeof(SnapshotHeader));
+	void* cursor;
+	for (Timer* timer = GxListIterBegin(timers, &cursor); timer != NULL; timer = GxListIterNext(&cursor)) {
+		GxSnapshotWrite_(snapshot, timer, sizeof(Timer));
+	}
+	GxPhysicsSaveSnapshot_(self->physics, snapshot);
+	for (Uint32 i = 0; i < header.nelements; i++) {
+		GxElement* elem = GxArrayAt(self->elements, i);
+		if (elem) GxElemSaveState_(elem, snapshot);
+	}
+}
+
+static inline bool sceneHasSavedElements(GxScene* self, const SnapshotHeader* header) {
+	//ids are never reused, so the saved elements are the live ones below the saved count
+	if (GxArraySize(self->elements) < header->nelements) return false;
+	Uint32 nlive = 0;
+	for (Uint32 i = 0; i < header->nelements; i++) {
+		if (GxArrayAt(self->elements, i)) nlive++;
+	}
+	return nlive == header->nlive;
+}
+
+bool GxSceneRestoreSnapshot(GxScene* self, const GxSnapshot* snapshot) {
+	GxAssertInvalidHash((*(Uint32*) self) == GxHashScene_);
+	size_t offset = 0;
+	SnapshotHeader header;
+	GxSnapshotRead_(snapshot, &offset, &header, sizeof(SnapshotHeader));
+	GxAssertInvalidArgument(header.scene == self);
+
+	//an element removed since the save cannot be brought back
+	if (!sceneHasSavedElements(self, &header)) return false;
+
+	//elements created since the save are removed, their destroy handlers may remove saved ones
+	for (Uint32 i = header.nelements; i < GxArraySize(self->elements); i++) {
+		GxElement* elem = GxArrayAt(self->elements, i);
+		if (elem) GxElemRemove(elem);
+	}
+	if (!sceneHasSavedElements(self, &header)) return false;
+
+	self->tick = header.tick;
+	GxList* timers = self->listeners[GxEventTimeout];
+	GxListClean(timers);
+	for (Uint32 i = 0; i < header.ntimers; i++) {
+		Timer* timer = malloc(sizeof(Timer));
+		GxAssertAllocationFailure(timer);
+		GxSnapshotRead_(snapshot, &offset, timer, sizeof(Timer));
+		GxListPush(timers, timer, free);
+	}
+	GxPhysicsRestoreSnapshot_(self->physics, snapshot, &offset);
+	for (Uint32 i = 0; i < header.nelements; i++) {
+		GxElement* elem = GxArrayAt(self->elements, i);
+		if (elem) GxElemRestoreState_(elem, snapshot, &offset);
+	}
+	return true;
+}
+
+void GxSceneAddElement_(GxScene* self, GxElement* elem, Uint32* id) {
 	
+	//the id is set before the modules see the element, physics keeps some of them by id
 	GxAssertInvalidOperation(self->status == GxStatusLoaded || self->status == GxStatusRunning);	
 	GxArrayPush(self->elements, elem, (GxDestructor) GxDestroyElement_);	
+	*id = GxArraySize(self->elements) - 1;
 	GxGraphicsInsertElement_(self->graphics, elem);
 	GxPhysicsInsertElement_(self->physics, elem);
 	GxSceneSubscribeElemListeners_(self, elem);
-	Uint32 id = GxArraySize(self->elements) - 1;
-	return id;
 }
 
 
@@ -366,11 +649,12 @@ static inline void sceneExecuteListeners(GxScene* self, int type, SDL_Event* sdl
 	}
 }
 
-static inline void sceneExecuteContactListeners(GxScene* self, int type, GxContact* contact) {
+static inline void sceneExecuteContactListeners(GxScene* self, int type, GxContact* contact, bool guard) {
+	//during a move the elements are locked, so handlers can't move them under the solver
 	GxElement* elemSelf = GxContactGetColliding(contact);
 	GxElement* elemOther = GxContactGetCollided(contact);
-	GxElemSetMcFlag_(elemSelf, true);
-	GxElemSetMcFlag_(elemOther, true);
+	GxElemSetMcFlag_(elemSelf, guard);
+	GxElemSetMcFlag_(elemOther, guard);
 
 	if (self->handlers && self->handlers[type]){
 		self->handlers[type](&(GxEvent) {
@@ -428,6 +712,8 @@ static void GxSceneLoad_(GxScene* self) {
 
 	//change status to running
 	self->status = GxStatusRunning;
+	self->lastCounter = SDL_GetPerformanceCounter();
+	self->accumulator = 0.0;
 }
 
 void GxSceneUnload_(GxScene* self) {
@@ -482,17 +768,9 @@ void GxSceneOnLoopBegin_(GxScene* self) {
 	}
 }
 
-void GxSceneOnUpdate_(GxScene* self) {
-	
-	if (self->status == GxStatusLoading) {
-		if (GxSceneGetPercLoaded(self) == 100) {
-			self->status = GxStatusLoaded;
-			GxSceneLoad_(self);
-		}
-		else {	
-			return;
-		}
-	}
+static void sceneTick(GxScene* self) {
+
+	self->tick++;
 
 	for (Timer* timer = GxListBegin(self->listeners[GxEventTimeout]); timer != NULL;
 		timer = GxListNext(self->listeners[GxEventTimeout])
@@ -509,6 +787,38 @@ void GxSceneOnUpdate_(GxScene* self) {
 	//execute update callbacks, then update physics
 	sceneExecuteListeners(self, GxEventOnUpdate, NULL);
 	GxPhysicsUpdate_(self->physics);	
+}
+
+void GxSceneOnUpdate_(GxScene* self) {
+	
+	if (self->status == GxStatusLoading) {
+		if (GxSceneGetPercLoaded(self) == 100) {
+			self->status = GxStatusLoaded;
+			GxSceneLoad_(self);
+		}
+		else {	
+			return;
+		}
+	}
+
+	if (self->tickRate) {
+		//consume the elapsed time in fixed ticks, dropping what exceeds maxTicks
+		Uint64 counter = SDL_GetPerformanceCounter();
+		double step = 1.0 / self->tickRate;
+		self->accumulator += (double) (counter - self->lastCounter) / SDL_GetPerformanceFrequency();
+		self->lastCounter = counter;
+		for (int i = 0; i < self->maxTicks && self->accumulator >= step; i++) {
+			sceneTick(self);
+			self->accumulator -= step;
+		}
+		if (self->accumulator >= step) {
+			self->accumulator -= step * (int) (self->accumulator / step);
+		}
+		self->alpha = self->accumulator / step;
+	}
+	else {
+		sceneTick(self);
+	}
 
 	//execute preGraphical callbacks, then update graphics
 	sceneExecuteListeners(self, GxEventOnPreGraphical, NULL);
@@ -556,13 +866,30 @@ void GxSceneOnSDLEvent_(GxScene* self, SDL_Event* e) {
 }
 
 void GxSceneOnPreContact_(GxScene* self, GxContact* contact) {
-	sceneExecuteContactListeners(self, GxEventPreContact, contact);
+	sceneExecuteContactListeners(self, GxEventPreContact, contact, true);
 }
 
 void GxSceneOnContactBegin_(GxScene* self, GxContact* contact) {
-	sceneExecuteContactListeners(self, GxEventContactBegin, contact);
+	sceneExecuteContactListeners(self, GxEventContactBegin, contact, true);
 }
 
 void GxSceneOnContactEnd_(GxScene* self, GxContact* contact) {
-	sceneExecuteContactListeners(self, GxEventContactEnd, contact);
+	sceneExecuteContactListeners(self, GxEventContactEnd, contact, true);
+}
+
+void GxSceneDispatchContact_(GxScene* self, int type, GxContact* contact) {
+	sceneExecuteContactListeners(self, type, contact, false);
+}
+
+void GxSceneOnSensor_(GxScene* self, int type, Uint32 sensor, Uint32 body) {
+	//the elements are looked up again after each handler, which may remove either of them,
+	//an exit still reaches the one left when the other was removed, with no other element
+	bool exit = type == GxEventSensorExit;
+	GxElement* elemSensor = GxSceneGetElement(self, sensor);
+	GxElement* elemBody = GxSceneGetElement(self, body);
+	if (elemSensor && (elemBody || exit)) GxElemExecuteSensorHandler_(elemSensor, type, elemBody);
+	
+	elemSensor = GxSceneGetElement(self, sensor);
+	elemBody = GxSceneGetElement(self, body);
+	if (elemBody && (elemSensor || exit)) GxElemExecuteSensorHandler_(elemBody, type, elemSensor);
 }
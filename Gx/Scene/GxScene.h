@@ -25,14 +25,42 @@ int GxSceneGetStatus(GxScene* self);
 GxElement* GxSceneGetElement(GxScene* self, Uint32 id);
 int GxSceneGetGravity(GxScene* self);
 bool GxSceneHasGravity(GxScene* self);
+int GxSceneGetTickRate(GxScene* self);
+double GxSceneGetAlpha(GxScene* self);
+Uint32 GxSceneGetTick_(GxScene* self);
+SDL_Rect GxSceneGetSimulationArea(GxScene* self);
+int GxSceneGetSimulationMargin(GxScene* self);
+int GxSceneGetFarRate(GxScene* self);
+bool GxSceneIsBatchingContacts(GxScene* self);
+bool GxSceneHasLooseTrees(GxScene* self);
+int GxSceneGetBroadphase(GxScene* self);
+int GxSceneGetCellSize(GxScene* self);
 GxPhysics* GxSceneGetPhysics(GxScene* self);
 GxGraphics* GxSceneGetGraphics(GxScene* self);
 GxElement* GxSceneGetCamera(GxScene* self);
+bool GxSceneRaycast(GxScene* self, SDL_Point from, SDL_Point to, Uint32 cmask, GxRayHit* hit);
+int GxSceneRaycastAll(GxScene* self, SDL_Point from, SDL_Point to, Uint32 cmask, 
+	GxRayHit* hits, int capacity
+);
+int GxSceneQueryRect(GxScene* self, SDL_Rect area, Uint32 cmask, GxElement** elems, int capacity);
+int GxSceneQueryPoint(GxScene* self, SDL_Point point, Uint32 cmask, GxElement** elems, int capacity);
+Uint32 GxSceneGetLayer(GxScene* self, const char* name);
+const char* GxSceneGetLayerName(GxScene* self, Uint32 layer);
+void GxSceneSetLayerCollision(GxScene* self, const char* layer, const char* other, bool collide);
+bool GxSceneLayersCollide(GxScene* self, const char* layer, const char* other);
+Uint32 GxSceneGetLayerMask_(GxScene* self, Uint32 layer);
 void GxScenePause(GxScene* self);
 void GxSceneResume(GxScene* self);
 void GxSceneSetGravity(GxScene* self, int gravity);
+void GxSceneSetSimulationArea(GxScene* self, const SDL_Rect* area);
+void GxSceneSetSimulationMargin(GxScene* self, int margin);
+void GxSceneSetFarRate(GxScene* self, int rate);
+void GxSceneSetBatchContacts(GxScene* self, bool value);
 void GxSceneSetTimeout(GxScene* self, int interval, GxHandler callback, void* target);
-Uint32 GxSceneAddElement_(GxScene* self, GxElement* elem);
+void GxSceneRebalance(GxScene* self);
+void GxSceneSaveSnapshot(GxScene* self, GxSnapshot* snapshot);
+bool GxSceneRestoreSnapshot(GxScene* self, const GxSnapshot* snapshot);
+void GxSceneAddElement_(GxScene* self, GxElement* elem, Uint32* id);
 void GxSceneRemoveElement_ (GxScene* self, GxElement* elem);
 void GxSceneSubscribeElemListeners_(GxScene* self, GxElement* elem);
 void GxSceneUnsubscribeElemListeners_(GxScene* self, GxElement* elem);
@@ -49,6 +77,8 @@ void GxSceneOnSDLEvent_(GxScene* self, SDL_Event* e);
 void GxSceneOnPreContact_(GxScene* self, GxContact* contact);
 void GxSceneOnContactBegin_(GxScene* self, GxContact* contact);
 void GxSceneOnContactEnd_(GxScene* self, GxContact* contact);
+void GxSceneDispatchContact_(GxScene* self, int type, GxContact* contact);
+void GxSceneOnSensor_(GxScene* self, int type, Uint32 sensor, Uint32 body);
 
 #endif // !GX_SCENE_H
 
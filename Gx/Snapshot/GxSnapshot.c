@@ -0,0 +1,29 @@
+#include "../Snapshot/GxSnapshot.h"
+#include <string.h>
+
+void GxFreeSnapshot(GxSnapshot* self) {
+	free(self->data);
+	self->data = NULL;
+	self->size = self->capacity = 0;
+}
+
+void GxSnapshotWrite_(GxSnapshot* self, const void* data, size_t size) {
+	if (!size) return;
+	if (self->size + size > self->capacity) {
+		size_t capacity = self->capacity ? self->capacity : 1024;
+		while (capacity < self->size + size) capacity *= 2;
+		self->data = realloc(self->data, capacity);
+		GxAssertAllocationFailure(self->data);
+		self->capacity = capacity;
+	}
+	memcpy((Uint8*) self->data + self->size, data, size);
+	self->size += size;
+}
+
+void GxSnapshotRead_(const GxSnapshot* self, size_t* offset, void* data, size_t size) {
+	//records are copied out, since the buffer keeps no alignment
+	if (!size) return;
+	GxAssertOutOfRange(*offset + size <= self->size);
+	memcpy(data, (const Uint8*) self->data + *offset, size);
+	*offset += size;
+}
@@ -0,0 +1,9 @@
+#ifndef GX_SNAPSHOT_H
+#define GX_SNAPSHOT_H
+#include "../Utilities/GxUtil.h"
+
+void GxFreeSnapshot(GxSnapshot* self);
+void GxSnapshotWrite_(GxSnapshot* self, const void* data, size_t size);
+void GxSnapshotRead_(const GxSnapshot* self, size_t* offset, void* data, size_t size);
+
+#endif // !GX_SNAPSHOT_H
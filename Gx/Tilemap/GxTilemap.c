@@ -3,6 +3,8 @@
 #include "../Renderable/GxRenderable.h"
 #include "../Folder/GxFolder.h"
 #include "../Scene/GxScene.h"
+#include "../RigidBody/GxRigidBody.h"
+#include "../Physics/GxPhysics.h"
 #include <string.h>
 
 typedef struct Tilemap {
@@ -14,6 +16,10 @@ typedef struct Tilemap {
 	char* folder;
 	char* group;
 	GxImage* pallete;
+	Uint8* tiles; //solid cells in grid mode, row by row
+	Uint32* colliders; //ids of the merged fixed bodies, removed along with the base
+	Uint32 ncolliders;
+	Uint32 ccolliders;
 }Tilemap;
 
 static const Uint32 tilemapHash = 1118096401;
@@ -26,19 +32,89 @@ bool GxIsTilemap(GxElement* elem) {
 
 static void onDestroyTilemap(GxEvent* e) {
 	Tilemap* self = e->target;
+	
+	//the base was removed on its own, its merged colliders go with it. An unloading scene
+	//destroys them itself
+	GxScene* scene = GxElemGetScene(self->base);
+	if (!GxSceneHasStatus(scene, GxStatusUnloading)) {
+		for (Uint32 i = 0; i < self->ncolliders; i++) {
+			GxElement* collider = GxSceneGetElement(scene, self->colliders[i]);
+			if (collider) GxElemRemove(collider);
+		}
+	}
+	free(self->colliders);
 	free(self->folder);
 	free(self->group);
 	free(self->sequence);
+	free(self->tiles);
 	self->hash = 0;
 	GxDestroyImage_(self->pallete);
 	free(self);
 }
 
+static inline bool tilemapIsRun(Tilemap* self, int row, int c0, int c1) {
+	//whether c0..c1 is a whole run of solid tiles in row, with no solid tile at either end
+	const Uint8* tiles = self->tiles + row * self->matrix.nc;
+	if (c0 > 0 && tiles[c0 - 1]) return false;
+	if (c1 + 1 < self->matrix.nc && tiles[c1 + 1]) return false;
+	for (int col = c0; col <= c1; col++) {
+		if (!tiles[col]) return false;
+	}
+	return true;
+}
+
+static void tilemapMerge(Tilemap* self, const GxIni* ini) {
+	//every run of solid tiles in a row grows down while the next row has the same run, so floors
+	//stay whole instead of being cut by the walls standing on them. Covered tiles are cleared
+	int nr = self->matrix.nr, nc = self->matrix.nc;
+	const SDL_Rect* pos = ini->position;
+	int tw = pos->w / nc, th = pos->h / nr;
+
+	for (int row = 0; row < nr; row++) {
+		for (int col = 0; col < nc; col++) {
+			if (!self->tiles[row * nc + col]) continue;
+			int c1 = col, r1 = row;
+			while (c1 + 1 < nc && self->tiles[row * nc + c1 + 1]) c1++;
+			while (r1 + 1 < nr && tilemapIsRun(self, r1 + 1, col, c1)) r1++;
+			for (int r = row; r <= r1; r++) {
+				memset(self->tiles + r * nc + col, 0, (size_t) (c1 - col + 1));
+			}
+
+			//the colliders share the tilemap's target and handlers, so its handlers run for their
+			//contacts with e->target set to the tilemap, while the contact itself holds the collider
+			if (self->ncolliders == self->ccolliders) {
+				self->ccolliders = self->ccolliders ? self->ccolliders * 2 : 8;
+				self->colliders = realloc(self->colliders, self->ccolliders * sizeof(Uint32));
+				GxAssertAllocationFailure(self->colliders);
+			}
+			GxElement* collider = GxCreateElement(&(GxIni) {
+				.className = ini->className,
+				.display = GxElemNone,
+				.body = GxElemFixed,
+				.layer = ini->layer,
+				.position = &(SDL_Rect) { 
+					pos->x + col * tw, 
+					pos->y + pos->h - (r1 + 1) * th, 
+					(c1 - col + 1) * tw, 
+					(r1 - row + 1) * th 
+				},
+				.target = GxElemGetTarget(self->base),
+				.onPreContact = ini->onPreContact,
+				.onContactBegin = ini->onContactBegin,
+				.onContactEnd = ini->onContactEnd,
+			});
+			self->colliders[self->ncolliders++] = GxElemGetId(collider);
+			col = c1;
+		}
+	}
+}
+
 GxElement* GxCreateTileMap(const char* tilePath, const GxIni* ini) {
 	
 	GxAssertInvalidArgument(ini->position && ini->position->w && ini->position->h &&
 		ini->matrix.nr && ini->matrix.nc && tilePath);
 	GxAssertInvalidArgument(ini->display == GxElemAbsolute || ini->display == GxElemRelative);
+	GxAssertInvalidArgument(ini->body != GxElemDynamic);
 	
 	Tilemap* self = calloc(1, sizeof(Tilemap));
 	GxAssertAllocationFailure(self);
@@ -58,8 +134,28 @@ GxElement* GxCreateTileMap(const char* tilePath, const GxIni* ini) {
 		group, (GxSize) { ini->position->w, ini->position->h }, ini->matrix, ini->sequence
 	);
 			
-	self->base = GxCreateElement(ini);
+	//in grid mode the base is a fixed body whose shape is read from the tiles, 
+	//when merged the tiles become separate fixed bodies and the base only renders
+	GxIni base = *ini;
+	if (ini->body == GxElemGrid || ini->body == GxElemMerged) {
+		base.body = ini->body == GxElemGrid ? GxElemFixed : GxElemNone;
+		self->tiles = malloc(self->size);
+		GxAssertAllocationFailure(self->tiles);
+		for (Uint32 i = 0; i < self->size; i++) {
+			self->tiles[i] = !self->sequence || self->sequence[i] != -1;
+		}
+	}
+
+	self->base = GxCreateElement(&base);
 	GxTilemapSetImage_(self->base, self->pallete);
+	if (ini->body == GxElemGrid) {
+		GxElemSetTileGrid_(self->base, self->matrix, self->tiles);
+	}
+	else if (ini->body == GxElemMerged) {
+		tilemapMerge(self, ini);
+		free(self->tiles);
+		self->tiles = NULL;
+	}
 	
 	self->folder = GmCreateString(folder);
 	self->group = GmCreateString(group);
@@ -73,4 +169,23 @@ GxElement* GxCreateTileMap(const char* tilePath, const GxIni* ini) {
 	return self->base;
 }
 
+static inline Tilemap* tilemapGrid(GxElement* elem, int row, int col) {
+	GxAssertInvalidArgument(GxIsTilemap(elem));
+	Tilemap* self = GxElemGetChild(elem);
+	GxAssertInvalidOperation(self->tiles);
+	GxAssertInvalidArgument(row >= 0 && row < self->matrix.nr && col >= 0 && col < self->matrix.nc);
+	return self;
+}
+
+bool GxTilemapIsSolid(GxElement* elem, int row, int col) {
+	Tilemap* self = tilemapGrid(elem, row, col);
+	return self->tiles[row * self->matrix.nc + col];
+}
 
+void GxTilemapSetSolid(GxElement* elem, int row, int col, bool solid) {
+	Tilemap* self = tilemapGrid(elem, row, col);
+	self->tiles[row * self->matrix.nc + col] = solid;
+
+	//bodies resting on a removed tile lose their support
+	GxPhysicsCheckContacts_(GxSceneGetPhysics(GxElemGetScene(elem)), self->base);
+}
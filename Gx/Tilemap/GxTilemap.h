@@ -6,4 +6,8 @@
 GxElement* GxCreateTileMap(const char* tilePath, const GxIni* ini);
 bool GxIsTilemap(GxElement* elem);
 
+//grid mode only, row 0 is the top row
+bool GxTilemapIsSolid(GxElement* elem, int row, int col);
+void GxTilemapSetSolid(GxElement* elem, int row, int col, bool solid);
+
 #endif // !GX_TILEMAP_H